@@ -0,0 +1,117 @@
+#pragma once
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// Layout of the binary result files. Numbers are stored in the byte order
+// of the machine writing the file, which is checked by the magic numbers.
+//
+// A file consists of:
+//   file header   - FileHeader followed by the names of the modules, each
+//                   a 32 bit length and the characters, padded to 8 bytes
+//   blocks        - one block per batch of consecutive events in event order
+//   index         - one IndexEntry per block
+//   footer        - Footer locating the index, at the very end of the file
+//
+// A block is a BlockHeader followed by its columns, each padded to 8 bytes:
+//   records    - uint32_t number of records of each event
+//   counts     - uint32_t number of values of each record, or the number of
+//                characters of a text record
+//   values     - uint32_t values of all records
+//   modules    - uint16_t module of each record, as index in the module
+//                names of the file, or TEXT_RECORD for free text
+//   text       - characters of all text records
+//
+// The text format of an event is "event #<number>\n", then for every record
+// either "<module>_<value>_<value>...\n" or the characters of the text
+// record, and a final "\n".
+struct BinaryFormat
+{
+    // "FWRS" identifies a result file
+    static constexpr uint32_t FILE_MAGIC = 0x53525746;
+
+    // "FWBK" identifies a block
+    static constexpr uint32_t BLOCK_MAGIC = 0x4b425746;
+
+    // "FWIX" identifies the footer
+    static constexpr uint32_t FOOTER_MAGIC = 0x58495746;
+
+    // version of the layout
+    static constexpr uint32_t VERSION = 1;
+
+    // module of records holding free text
+    static constexpr uint16_t TEXT_RECORD = 0xffff;
+
+    // alignment of the sections and columns
+    static constexpr size_t ALIGNMENT = 8;
+
+    struct FileHeader {
+        uint32_t magic;
+        uint32_t version;
+        uint32_t number_of_modules;
+        uint32_t reserved;
+    };
+
+    struct BlockHeader {
+        uint32_t magic;
+        uint32_t first_event;
+        uint32_t number_of_events;
+        uint32_t number_of_records;
+        uint32_t number_of_values;
+        uint32_t text_size;
+    };
+
+    struct IndexEntry {
+        uint32_t first_event;
+        uint32_t number_of_events;
+        uint64_t offset;
+    };
+
+    struct Footer {
+        uint64_t index_offset;
+        uint64_t number_of_blocks;
+        uint32_t magic;
+        uint32_t version;
+    };
+
+    // Returns the size rounded up to the alignment.
+    static size_t align(size_t size) {
+        return (size + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+    }
+
+    // Returns the size of a block including its header.
+    static size_t getBlockSize(const BlockHeader& header) {
+        return align(sizeof(BlockHeader)) + align(header.number_of_events * sizeof(uint32_t))
+            + align(header.number_of_records * sizeof(uint32_t))
+            + align(header.number_of_values * sizeof(uint32_t))
+            + align(header.number_of_records * sizeof(uint16_t)) + align(header.text_size);
+    }
+
+    // Write the file header with the given module names.
+    // returns: the number of bytes written.
+    static size_t writeFileHeader(std::ostream& output, const std::vector<std::string>& module_names) {
+        FileHeader header {FILE_MAGIC, VERSION, static_cast<uint32_t>(module_names.size()), 0};
+        output.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        size_t size = sizeof(header);
+
+        for (const std::string& name : module_names) {
+            uint32_t length = static_cast<uint32_t>(name.size());
+            output.write(reinterpret_cast<const char*>(&length), sizeof(length));
+            output.write(name.data(), name.size());
+            size += sizeof(length) + name.size();
+        }
+
+        return size + writePadding(output, size);
+    }
+
+    // Write zeros up to the next multiple of the alignment.
+    // returns: the number of bytes written.
+    static size_t writePadding(std::ostream& output, size_t size) {
+        static const char zeros[ALIGNMENT] = {};
+        size_t padding = align(size) - size;
+        output.write(zeros, padding);
+        return padding;
+    }
+};
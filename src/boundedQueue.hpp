@@ -0,0 +1,131 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+// Lock free bounded queue safe for multiple producers and multiple consumers.
+// Each slot of the ring carries a sequence number telling whether it is
+// ready to be written or read in the current lap, so producers and consumers
+// only contend on the slot they are claiming.
+// See: http://www.1024cores.net/home/lock-free-algorithms/queues/bounded-mpmc-queue
+template <typename T>
+class BoundedQueue
+{
+public:
+    // Construct a queue holding at least the given number of elements. The
+    // capacity is rounded up to a power of two.
+    explicit BoundedQueue(size_t capacity)
+    {
+        size_t size = 2;
+        while (size < capacity) {
+            size <<= 1;
+        }
+
+        mask_ = size - 1;
+        buffer_.reset(new Cell[size]);
+        for (size_t i = 0; i < size; ++i) {
+            buffer_[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    // Copys are not allowed.
+    BoundedQueue(const BoundedQueue&) = delete;
+    BoundedQueue& operator=(const BoundedQueue&) = delete;
+
+    // Returns the number of elements the queue can hold.
+    size_t capacity() const {
+        return mask_ + 1;
+    }
+
+    // Returns whether the queue looks empty. Only a hint when used
+    // concurrently with the producers and consumers.
+    bool empty() const {
+        return enqueue_position_.value.load(std::memory_order_acquire)
+            == dequeue_position_.value.load(std::memory_order_acquire);
+    }
+
+    // Insert an element at the back of the queue.
+    // returns: false if the queue is full and the element was not inserted.
+    bool push(T&& data)
+    {
+        Cell* cell;
+        size_t position = enqueue_position_.value.load(std::memory_order_relaxed);
+        while (true) {
+            cell = &buffer_[position & mask_];
+            size_t sequence = cell->sequence.load(std::memory_order_acquire);
+            intptr_t difference = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(position);
+            if (difference == 0) {
+                if (enqueue_position_.value.compare_exchange_weak(position, position + 1,
+                        std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (difference < 0) {
+                return false;
+            } else {
+                position = enqueue_position_.value.load(std::memory_order_relaxed);
+            }
+        }
+
+        cell->data = std::move(data);
+        cell->sequence.store(position + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Take the element at the front of the queue.
+    // returns: false if the queue is empty and nothing was taken.
+    bool pop(T& data)
+    {
+        Cell* cell;
+        size_t position = dequeue_position_.value.load(std::memory_order_relaxed);
+        while (true) {
+            cell = &buffer_[position & mask_];
+            size_t sequence = cell->sequence.load(std::memory_order_acquire);
+            intptr_t difference = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(position + 1);
+            if (difference == 0) {
+                if (dequeue_position_.value.compare_exchange_weak(position, position + 1,
+                        std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (difference < 0) {
+                return false;
+            } else {
+                position = dequeue_position_.value.load(std::memory_order_relaxed);
+            }
+        }
+
+        data = std::move(cell->data);
+        cell->sequence.store(position + mask_ + 1, std::memory_order_release);
+        return true;
+    }
+
+private:
+    // size of a cache line, used to keep the positions apart
+    static constexpr size_t CACHE_LINE_SIZE = 64;
+
+    // slot of the ring
+    struct Cell {
+        std::atomic<size_t> sequence;
+        T data;
+    };
+
+    // ring of slots
+    std::unique_ptr<Cell[]> buffer_;
+
+    // mask used to wrap positions around the ring
+    size_t mask_ {0};
+
+    // position in the ring padded to sit alone on its cache line
+    struct Position {
+        char head[CACHE_LINE_SIZE];
+        std::atomic<size_t> value {0};
+        char tail[CACHE_LINE_SIZE - sizeof(std::atomic<size_t>)];
+    };
+
+    // position of the next slot to write
+    Position enqueue_position_;
+
+    // position of the next slot to read
+    Position dequeue_position_;
+};
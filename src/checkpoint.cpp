@@ -0,0 +1,125 @@
+#include "checkpoint.hpp"
+
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+
+Checkpoint::Checkpoint(const Configuration& config)
+    : next_event_(config.getFirstEvent()), initial_seed_(config.getInitialSeed()),
+      first_event_(config.getFirstEvent()), last_event_(config.getLastEvent()),
+      random_engine_(config.getRandomEngine()),
+      event_seeding_(config.useCounterSeeding() ? "counter" : "sequential"),
+      output_format_(config.getOutputFormat()), input_file_(config.getInputFile()),
+      input_record_size_(config.getInputRecordSize()),
+      module_streams_(config.useGraphExecution() ? "own" : "shared")
+{
+    for (const std::string& module : config.getModuleNames()) {
+        modules_ += (modules_.empty() ? "" : " ") + module;
+    }
+}
+
+// Read the checkpoint from a file.
+bool Checkpoint::read(const std::string& path)
+{
+    std::ifstream file(path);
+    if (!file) {
+        return false;
+    }
+
+    // read the file line by line expecting a key-value pair on each line
+    int seen_keys = 0;
+    module_streams_ = "shared";
+    std::string line;
+    while (getline(file, line)) {
+        std::stringstream tokenizer(line);
+        std::string key, equal_sign, value;
+        tokenizer >> key >> equal_sign;
+        std::getline(tokenizer >> std::ws, value);
+        if (equal_sign != "=") {
+            return false;
+        }
+
+        ++seen_keys;
+        try {
+            if (key == "next_event") {
+                next_event_ = static_cast<unsigned int>(std::stoul(value));
+            } else if (key == "output_offset") {
+                output_offset_ = std::stoull(value);
+            } else if (key == "initial_seed") {
+                initial_seed_ = static_cast<unsigned int>(std::stoul(value));
+            } else if (key == "first_event") {
+                first_event_ = static_cast<unsigned int>(std::stoul(value));
+            } else if (key == "last_event") {
+                last_event_ = static_cast<unsigned int>(std::stoul(value));
+            } else if (key == "modules") {
+                modules_ = value;
+            } else if (key == "random_engine") {
+                random_engine_ = value;
+            } else if (key == "event_seeding") {
+                event_seeding_ = value;
+            } else if (key == "output_format") {
+                output_format_ = value;
+            } else if (key == "input_file") {
+                // optional, only written by simulations with an input file
+                input_file_ = value;
+                --seen_keys;
+            } else if (key == "input_record_size") {
+                input_record_size_ = static_cast<unsigned int>(std::stoul(value));
+                --seen_keys;
+            } else if (key == "module_streams") {
+                // optional, only written by simulations giving every module
+                // a random number stream of its own
+                module_streams_ = value;
+                --seen_keys;
+            } else {
+                --seen_keys;
+            }
+        } catch (...) {
+            return false;
+        }
+    }
+
+    return seen_keys == 9;
+}
+
+// Write the checkpoint to a file.
+bool Checkpoint::write(const std::string& path) const
+{
+    std::string temporary_path = path + ".tmp";
+    {
+        std::ofstream file(temporary_path, std::ios::trunc);
+        file << "next_event = " << next_event_ << '\n'
+            << "output_offset = " << output_offset_ << '\n'
+            << "initial_seed = " << initial_seed_ << '\n'
+            << "first_event = " << first_event_ << '\n'
+            << "last_event = " << last_event_ << '\n'
+            << "modules = " << modules_ << '\n'
+            << "random_engine = " << random_engine_ << '\n'
+            << "event_seeding = " << event_seeding_ << '\n'
+            << "output_format = " << output_format_ << '\n';
+        if (!input_file_.empty()) {
+            file << "input_file = " << input_file_ << '\n'
+                << "input_record_size = " << input_record_size_ << '\n';
+        }
+        if (module_streams_ != "shared") {
+            file << "module_streams = " << module_streams_ << '\n';
+        }
+        file.flush();
+        if (!file) {
+            return false;
+        }
+    }
+
+    return std::rename(temporary_path.c_str(), path.c_str()) == 0;
+}
+
+// Returns whether the checkpoint was taken by a simulation producing the
+// same results.
+bool Checkpoint::matches(const Checkpoint& other) const
+{
+    return initial_seed_ == other.initial_seed_ && first_event_ == other.first_event_
+        && last_event_ == other.last_event_ && modules_ == other.modules_
+        && random_engine_ == other.random_engine_ && event_seeding_ == other.event_seeding_
+        && output_format_ == other.output_format_ && input_file_ == other.input_file_
+        && input_record_size_ == other.input_record_size_ && module_streams_ == other.module_streams_;
+}
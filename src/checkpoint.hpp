@@ -0,0 +1,71 @@
+#pragma once
+
+#include "configuration.hpp"
+
+#include <cstdint>
+#include <string>
+
+// Progress of a simulation writing its results to an output file. All events
+// before the next event are written to the first output offset bytes of the
+// file, so a simulation can resume from the next event after truncating the
+// file to this size.
+//
+// The checkpoint also holds the settings that determine the results, so it
+// is only used to resume a simulation producing the same results. Stored as
+// a text file of key = value lines like the configuration file.
+class Checkpoint
+{
+public:
+    // Create the checkpoint of a simulation with the given configuration
+    // before any event is executed.
+    explicit Checkpoint(const Configuration& config);
+
+    // Read the checkpoint from a file.
+    // returns: false if the file can't be read or is not a checkpoint.
+    bool read(const std::string& path);
+
+    // Write the checkpoint to a file. The checkpoint is written to a
+    // temporary file renamed over the file, so the file always holds a
+    // complete checkpoint even if the program is killed while writing.
+    // returns: false if the file can't be written.
+    bool write(const std::string& path) const;
+
+    // Returns whether the checkpoint was taken by a simulation producing
+    // the same results.
+    bool matches(const Checkpoint& other) const;
+
+    // Returns the number of the next event to execute.
+    unsigned int getNextEvent() const {
+        return next_event_;
+    }
+
+    // Returns the size of the output written by the events before the next one.
+    uint64_t getOutputOffset() const {
+        return output_offset_;
+    }
+
+    // Record the progress of the simulation.
+    void setProgress(unsigned int next_event, uint64_t output_offset) {
+        next_event_ = next_event;
+        output_offset_ = output_offset;
+    }
+
+private:
+    // number of the next event to execute
+    unsigned int next_event_ {1};
+
+    // size of the output written by the events before the next one
+    uint64_t output_offset_ {0};
+
+    // settings of the simulation determining the results
+    unsigned int initial_seed_ {0};
+    unsigned int first_event_ {1};
+    unsigned int last_event_ {0};
+    std::string modules_;
+    std::string random_engine_;
+    std::string event_seeding_;
+    std::string output_format_;
+    std::string input_file_;
+    unsigned int input_record_size_ {0};
+    std::string module_streams_;
+};
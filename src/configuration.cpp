@@ -2,6 +2,7 @@
 #include <fstream>
 #include <sstream>
 #include <iostream>
+#include <cstdint>
 #include <ctime>
 
 // Helper to parse a number
@@ -20,20 +21,61 @@ unsigned int parseNumber(std::string number)
 
 Configuration Configuration::createConfiguration(std::string config_file_path)
 {
-    Configuration config;
-
     // open config file
     std::ifstream config_file(config_file_path);
     if (!config_file) {
         std::cerr << "ERROR: Couldn't open configuration file " << config_file_path << '\n';
-        return config;
+        return Configuration();
+    }
+
+    return createConfiguration(config_file);
+}
+
+// Restrict the events to execute to one shard of the range of events.
+bool Configuration::selectShard(unsigned int shard, unsigned int number_of_shards)
+{
+    if (shard == 0 || shard > number_of_shards) {
+        std::cerr << "ERROR: Invalid shard " << shard << '/' << number_of_shards << '\n';
+        return false;
+    }
+
+    // shards differ by at most one event if the range doesn't divide evenly
+    uint64_t first = first_event_;
+    uint64_t number_of_events = getLastEvent() >= first_event_ ? getLastEvent() - first + 1 : 0;
+    uint64_t begin = first + (shard - 1) * number_of_events / number_of_shards;
+    uint64_t end = first + shard * number_of_events / number_of_shards;
+
+    first_event_ = static_cast<unsigned int>(begin);
+    last_event_ = static_cast<unsigned int>(end - 1);
+    if (last_event_ == 0) {
+        // a last event of zero would mean all events
+        number_of_events_ = 0;
+    }
+
+    std::string suffix = ".shard" + std::to_string(shard);
+    if (!output_file_.empty()) {
+        output_file_ += suffix;
     }
+    if (!checkpoint_file_.empty()) {
+        checkpoint_file_ += suffix;
+    }
+
+    return true;
+}
+
+Configuration Configuration::createConfiguration(std::istream& config_file)
+{
+    Configuration config;
 
     // what we are looking for to consider this file as correct and return a valid object
     bool seen_number_of_events_before = false;
     bool seen_modules_before = false;
     bool seen_seed_before = false;
 
+    // names of the modules depending on other modules, each followed by
+    // the names of its dependencies, resolved once all modules are known
+    std::vector<std::vector<std::string>> dependencies;
+
     // read the file line by line expecting a key-value pair on each line.
     std::string line;
     while (getline(config_file, line)) {
@@ -65,11 +107,132 @@ Configuration Configuration::createConfiguration(std::string config_file_path)
                 seen_number_of_events_before = true;
             }
         } else if (key == "number_of_threads") {
+            if (value == "auto") {
+                config.automatic_threads_ = true;
+            } else {
+                try {
+                    config.number_of_threads_ = parseNumber(value);
+                    config.automatic_threads_ = false;
+                } catch (...) {
+                    return config;
+                }
+            }
+        } else if (key == "max_pending_events") {
+            try {
+                config.max_pending_events_ = parseNumber(value);
+            } catch (...) {
+                return config;
+            }
+        } else if (key == "grain_size") {
+            if (value == "auto") {
+                config.grain_size_ = 0;
+            } else {
+                try {
+                    config.grain_size_ = parseNumber(value);
+                } catch (...) {
+                    return config;
+                }
+            }
+        } else if (key == "random_engine") {
+            config.random_engine_ = value;
+        } else if (key == "first_event") {
+            try {
+                config.first_event_ = parseNumber(value);
+            } catch (...) {
+                return config;
+            }
+        } else if (key == "last_event") {
+            try {
+                config.last_event_ = parseNumber(value);
+            } catch (...) {
+                return config;
+            }
+        } else if (key == "event_seeding") {
+            if (value != "sequential" && value != "counter") {
+                std::cerr << "ERROR: Unknown event seeding " << value << '\n';
+                return config;
+            }
+            config.counter_seeding_ = (value == "counter");
+        } else if (key == "instrumentation") {
+            if (value != "on" && value != "off") {
+                std::cerr << "ERROR: Unknown instrumentation mode " << value << '\n';
+                return config;
+            }
+            config.instrumentation_ = (value == "on");
+        } else if (key == "output_format") {
+            if (value != "text" && value != "binary" && value != "summary") {
+                std::cerr << "ERROR: Unknown output format " << value << '\n';
+                return config;
+            }
+            config.output_format_ = value;
+        } else if (key == "output_file") {
+            config.output_file_ = value;
+        } else if (key == "input_file") {
+            config.input_file_ = value;
+        } else if (key == "input_record_size") {
+            try {
+                config.input_record_size_ = parseNumber(value);
+            } catch (...) {
+                return config;
+            }
+        } else if (key == "result_cache") {
+            config.result_cache_ = value;
+        } else if (key == "result_cache_size") {
             try {
-                config.number_of_threads_ = parseNumber(value);
+                config.result_cache_size_ = parseNumber(value);
             } catch (...) {
                 return config;
             }
+        } else if (key == "checkpoint_file") {
+            config.checkpoint_file_ = value;
+        } else if (key == "checkpoint_interval") {
+            try {
+                config.checkpoint_interval_ = parseNumber(value);
+            } catch (...) {
+                return config;
+            }
+        } else if (key == "worker_affinity") {
+            if (value != "none" && value != "cpu" && value != "node") {
+                std::cerr << "ERROR: Unknown worker affinity " << value << '\n';
+                return config;
+            }
+            config.worker_affinity_ = value;
+        } else if (key == "worker_cpus") {
+            config.worker_cpus_ = value;
+        } else if (key == "execution") {
+            if (value != "auto" && value != "events" && value != "blocks" && value != "pipeline"
+                    && value != "graph") {
+                std::cerr << "ERROR: Unknown execution mode " << value << '\n';
+                return config;
+            }
+            config.execution_ = value;
+        } else if (key == "pipeline_stages") {
+            config.pipeline_stages_.clear();
+            do {
+                try {
+                    unsigned int size = parseNumber(value);
+                    if (size == 0) {
+                        std::cerr << "ERROR: Empty pipeline stage\n";
+                        return config;
+                    }
+                    config.pipeline_stages_.push_back(size);
+                } catch (...) {
+                    return config;
+                }
+            } while (tokenizer >> value);
+        } else if (key == "module_dependencies") {
+            dependencies.emplace_back();
+            do {
+                dependencies.back().push_back(value);
+            } while (tokenizer >> value);
+        } else if (key == "trace_file") {
+            config.trace_file_ = value;
+        } else if (key == "scheduler") {
+            if (value != "shared_queue" && value != "work_stealing") {
+                std::cerr << "ERROR: Unknown scheduler " << value << '\n';
+                return config;
+            }
+            config.scheduler_ = value;
         } else if (key == "initial_seed") {
             try {
                 config.initial_seed_ = parseNumber(value);
@@ -95,6 +258,94 @@ Configuration Configuration::createConfiguration(std::string config_file_path)
         config.initial_seed_ = static_cast<unsigned int>(time(NULL));
     }
 
+    // check the range of events to execute is within the simulation
+    if (config.number_of_events_ > 0 && (config.first_event_ == 0
+            || config.first_event_ > config.getLastEvent()
+            || config.getLastEvent() > config.number_of_events_)) {
+        std::cerr << "ERROR: Invalid range of events " << config.first_event_
+            << ".." << config.getLastEvent() << '\n';
+        return config;
+    }
+
+    // binary results can't be mixed with the messages on standard out
+    if (config.output_format_ == "binary" && config.output_file_.empty()) {
+        std::cerr << "ERROR: Binary output requires an output_file\n";
+        return config;
+    }
+
+    // a checkpoint records how much of the output file is written
+    if (!config.checkpoint_file_.empty() && config.output_file_.empty()) {
+        std::cerr << "ERROR: Checkpoints require an output_file\n";
+        return config;
+    }
+
+    // the summary only exists once all events are executed
+    if (!config.checkpoint_file_.empty() && config.output_format_ == "summary") {
+        std::cerr << "ERROR: Checkpoints require results written per event\n";
+        return config;
+    }
+
+    // results are taken from the cache event by event
+    if (!config.result_cache_.empty() && config.execution_ != "auto" && config.execution_ != "events") {
+        std::cerr << "ERROR: The result cache requires the execution of events\n";
+        return config;
+    }
+
+    // only the pipeline splits the modules into stages
+    if (!config.pipeline_stages_.empty() && config.execution_ != "pipeline") {
+        std::cerr << "ERROR: Pipeline stages require the execution of a pipeline\n";
+        return config;
+    }
+
+    // every module belongs to one stage of the pipeline
+    if (!config.pipeline_stages_.empty()) {
+        size_t number_of_modules = 0;
+        for (unsigned int size : config.pipeline_stages_) {
+            number_of_modules += size;
+        }
+        if (number_of_modules != config.module_names_.size()) {
+            std::cerr << "ERROR: Pipeline stages have " << number_of_modules << " modules instead of "
+                << config.module_names_.size() << '\n';
+            return config;
+        }
+    }
+
+    // only the graph of the modules starts them after their dependencies
+    if (!dependencies.empty() && config.execution_ != "graph") {
+        std::cerr << "ERROR: Module dependencies require the execution of a graph\n";
+        return config;
+    }
+
+    // a module depends on the modules of the given names configured before
+    // it, every module of its name has these dependencies
+    config.module_dependencies_.resize(config.module_names_.size());
+    for (const std::vector<std::string>& names : dependencies) {
+        bool found = false;
+        for (size_t m = 0; m < config.module_names_.size(); ++m) {
+            if (config.module_names_[m] != names.front()) {
+                continue;
+            }
+            found = true;
+            for (size_t d = 1; d < names.size(); ++d) {
+                size_t before = config.module_dependencies_[m].size();
+                for (size_t dependency = 0; dependency < m; ++dependency) {
+                    if (config.module_names_[dependency] == names[d]) {
+                        config.module_dependencies_[m].push_back(static_cast<unsigned int>(dependency));
+                    }
+                }
+                if (config.module_dependencies_[m].size() == before) {
+                    std::cerr << "ERROR: Module " << names.front() << " depends on " << names[d]
+                        << " which is not configured before it\n";
+                    return config;
+                }
+            }
+        }
+        if (!found) {
+            std::cerr << "ERROR: Dependencies of unknown module " << names.front() << '\n';
+            return config;
+        }
+    }
+
     // check we have the needed values
     config.correct_ = seen_number_of_events_before && seen_modules_before && config.module_names_.size() > 0;
 
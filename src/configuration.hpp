@@ -3,6 +3,7 @@
 #include <vector>
 #include <string>
 #include <map>
+#include <istream>
 
 // Simulation configuration file. Very basic configuration file that reads
 // basic information about the simulation.
@@ -13,9 +14,27 @@ public:
     // Create the configuration object from the configuration file.
     static Configuration createConfiguration(std::string config_file_path);
 
+    // Create the configuration object from the content of a configuration
+    // file, e.g. a configuration generated in memory.
+    static Configuration createConfiguration(std::istream& config_file);
+
     // Return whether the configuration is correct or not.
     bool correct() const { return correct_; }
 
+    // Restrict the events to execute to one shard of the range of events.
+    // The range is split into the given number of consecutive shards of
+    // nearly equal size, numbered from 1, so shards executed by separate
+    // processes together execute every event once. Output and checkpoint
+    // files get the suffix ".shard<number>" to keep the shards apart.
+    // returns: false if the shard is not one of the shards.
+    bool selectShard(unsigned int shard, unsigned int number_of_shards);
+
+    // Write the results to the given file instead of the output file of
+    // the configuration file, if any.
+    void setOutputFile(const std::string& path) {
+        output_file_ = path;
+    }
+
     // Returns the user specified initial seed.
     unsigned int getInitialSeed() const {
         return initial_seed_;
@@ -31,11 +50,159 @@ public:
         return number_of_events_;
     }
 
+    // Returns the number of the first event to execute. Events before it
+    // are skipped, which allows to rerun a slice of a simulation.
+    unsigned int getFirstEvent() const {
+        return first_event_;
+    }
+
+    // Returns the number of the last event to execute.
+    unsigned int getLastEvent() const {
+        return last_event_ > 0 ? last_event_ : number_of_events_;
+    }
+
+    // Returns whether the seeds of the events are derived from the initial
+    // seed and the event number instead of drawn in sequence.
+    bool useCounterSeeding() const {
+        return counter_seeding_;
+    }
+
     // Returns the user specified number of threads.
     unsigned int getNumberOfThreads() const {
         return number_of_threads_;
     }
 
+    // Returns whether the framework chooses the number of threads from the
+    // CPUs available and the cost of the events.
+    bool useAutomaticThreads() const {
+        return automatic_threads_;
+    }
+
+    // Returns the user specified maximum number of events waiting for
+    // execution. Zero means the framework chooses the limit.
+    unsigned int getMaxPendingEvents() const {
+        return max_pending_events_;
+    }
+
+    // Returns the user specified number of events executed by each task.
+    // Zero means the framework chooses the number.
+    unsigned int getGrainSize() const {
+        return grain_size_;
+    }
+
+    // Returns the name of the random number engine used by the events.
+    std::string getRandomEngine() const {
+        return random_engine_;
+    }
+
+    // Returns the name of the scheduler used to execute the events.
+    std::string getScheduler() const {
+        return scheduler_;
+    }
+
+    // Returns the format of the results, text, binary or summary.
+    std::string getOutputFormat() const {
+        return output_format_;
+    }
+
+    // Returns the path of the file the results are written to, empty if
+    // they are written to standard out.
+    std::string getOutputFile() const {
+        return output_file_;
+    }
+
+    // Returns the path of the file holding the records of the events, empty
+    // if the events have no input.
+    std::string getInputFile() const {
+        return input_file_;
+    }
+
+    // Returns the size of every record of an input file of fixed size
+    // records, zero for an indexed input file, see inputFile.hpp.
+    unsigned int getInputRecordSize() const {
+        return input_record_size_;
+    }
+
+    // Returns the directory of the result cache the results of the modules
+    // are kept in for the following runs, empty if they are not kept, see
+    // resultCache.hpp.
+    std::string getResultCache() const {
+        return result_cache_;
+    }
+
+    // Returns the limit on the size of the result cache in MiB.
+    unsigned int getResultCacheSize() const {
+        return result_cache_size_;
+    }
+
+    // Returns the path of the file the progress of the simulation is saved
+    // to, empty if no checkpoints are taken.
+    std::string getCheckpointFile() const {
+        return checkpoint_file_;
+    }
+
+    // Returns the number of events between checkpoints.
+    unsigned int getCheckpointInterval() const {
+        return checkpoint_interval_ > 0 ? checkpoint_interval_ : 1;
+    }
+
+    // Returns how the worker threads are pinned to the CPUs: none, cpu to
+    // pin each worker to one CPU or node to pin the workers to the CPUs of
+    // a NUMA node and give every node its own queue.
+    std::string getWorkerAffinity() const {
+        return worker_affinity_;
+    }
+
+    // Returns the list of CPUs the workers are pinned to, e.g. "0-3,8-11",
+    // empty for all CPUs the process may run on.
+    std::string getWorkerCpus() const {
+        return worker_cpus_;
+    }
+
+    // Returns how the modules execute the events: auto, events, blocks,
+    // pipeline or graph.
+    std::string getExecution() const {
+        return execution_;
+    }
+
+    // Returns whether the modules are executed as the stages of a pipeline,
+    // each stage on its own thread, instead of executing whole events in
+    // parallel.
+    bool usePipelineExecution() const {
+        return execution_ == "pipeline";
+    }
+
+    // Returns whether the modules of an event are executed in parallel as
+    // far as their dependencies allow, each module drawing from a random
+    // number stream of its own.
+    bool useGraphExecution() const {
+        return execution_ == "graph";
+    }
+
+    // Returns the indices of the modules every module depends on, which
+    // come before it in the list of modules. Only used by the execution of
+    // the graph of the modules.
+    std::vector<std::vector<unsigned int>> getModuleDependencies() const {
+        return module_dependencies_;
+    }
+
+    // Returns the number of consecutive modules executed by each stage of
+    // the pipeline, empty for one stage per module.
+    std::vector<unsigned int> getPipelineStages() const {
+        return pipeline_stages_;
+    }
+
+    // Returns whether timing statistics of the simulation are recorded.
+    bool useInstrumentation() const {
+        return instrumentation_ || !trace_file_.empty();
+    }
+
+    // Returns the path of the file the trace of the simulation is written
+    // to, empty if no trace is written.
+    std::string getTraceFile() const {
+        return trace_file_;
+    }
+
 private:
     Configuration() = default;
 
@@ -51,6 +218,100 @@ private:
     // total number of events
     unsigned int number_of_events_ {0};
 
-    // optional number specifing the number of threads to use. Default is zero.
+    // optional number of the first event to execute. Default is the first one.
+    unsigned int first_event_ {1};
+
+    // optional number of the last event to execute. Default is zero which
+    // means the last event of the simulation.
+    unsigned int last_event_ {0};
+
+    // optional seeding mode of the events. Default is the sequential mode
+    // where seeds are drawn from the main generator in event order.
+    bool counter_seeding_ {false};
+
+    // optional number specifing the number of threads to use, zero executes
+    // the events on the main thread. Default is auto which lets the
+    // framework choose the number.
     unsigned int number_of_threads_ {0};
+    bool automatic_threads_ {true};
+
+    // optional limit on the number of submitted events waiting for execution.
+    // Default is zero which lets the framework choose the limit.
+    unsigned int max_pending_events_ {0};
+
+    // optional number of consecutive events executed by each task. Default
+    // is zero which lets the framework tune the number.
+    unsigned int grain_size_ {0};
+
+    // optional name of the random number engine used by the events. Default
+    // is the mersenne twister.
+    std::string random_engine_ {"mt19937"};
+
+    // optional name of the scheduler executing the events. Default is the
+    // shared queue thread pool.
+    std::string scheduler_ {"shared_queue"};
+
+    // optional format of the results. Default is text, binary results are
+    // described in binaryFormat.hpp and summary only writes the aggregates
+    // of the values of all events described in summary.hpp.
+    std::string output_format_ {"text"};
+
+    // optional path of the file the results are written to. Default is
+    // empty which means standard out.
+    std::string output_file_;
+
+    // optional path of the file holding a record per event. Default is empty
+    // which means the events have no input.
+    std::string input_file_;
+
+    // optional size of the records of the input file. Default is zero which
+    // means the input file is indexed.
+    unsigned int input_record_size_ {0};
+
+    // optional directory keeping the results of the modules for the
+    // following runs. Default is empty which means no results are kept.
+    std::string result_cache_;
+
+    // optional limit on the size of the result cache in MiB. Default is 1024.
+    unsigned int result_cache_size_ {1024};
+
+    // optional path of the file the progress of the simulation is saved to.
+    // Default is empty which means no checkpoints are taken.
+    std::string checkpoint_file_;
+
+    // optional number of events between checkpoints. Default is 100000.
+    unsigned int checkpoint_interval_ {100000};
+
+    // optional placement of the worker threads on the CPUs. Default is none
+    // which leaves the placement to the operating system.
+    std::string worker_affinity_ {"none"};
+
+    // optional list of CPUs the workers are pinned to. Default is empty
+    // which means all CPUs the process may run on.
+    std::string worker_cpus_;
+
+    // optional execution mode. Events executes whole events in parallel,
+    // one event at a time per thread, blocks executes each module for a
+    // block of events at once and pipeline executes the modules as stages
+    // of a pipeline and graph executes the modules of an event in parallel
+    // as far as their dependencies allow. Default is auto which executes
+    // blocks if all modules implement the block interface and events
+    // otherwise.
+    std::string execution_ {"auto"};
+
+    // optional indices of the modules every module depends on. Default is
+    // no dependencies.
+    std::vector<std::vector<unsigned int>> module_dependencies_;
+
+    // optional number of modules of each stage of the pipeline. Default is
+    // empty which means one stage per module.
+    std::vector<unsigned int> pipeline_stages_;
+
+    // optional switch recording timing statistics of the simulation. Default
+    // is off.
+    bool instrumentation_ {false};
+
+    // optional path of a chrome trace event file written after the
+    // simulation. Setting it turns the instrumentation on.
+    std::string trace_file_;
 };
@@ -0,0 +1,52 @@
+#include "resultFile.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+
+// Converts a binary result file back to the text results of the simulation.
+//
+// Usage: framework_convert results.bin [first_event last_event]
+//
+// Writes the text of the events in the range, all events by default, to
+// standard out exactly as a simulation with text output does.
+int main(int argc, char* argv[])
+{
+    if (argc != 2 && argc != 4) {
+        std::cerr << "ERROR: Incorrect arguments\n";
+        std::cerr << "Usage: framework_convert results.bin [first_event last_event]\n";
+        return -1;
+    }
+
+    std::unique_ptr<ResultFile> file = ResultFile::createResultFile(argv[1]);
+    if (!file) {
+        return -1;
+    }
+
+    unsigned int first = file->getFirstEvent();
+    unsigned int last = file->getLastEvent();
+    if (argc == 4) {
+        first = static_cast<unsigned int>(std::strtoul(argv[2], nullptr, 10));
+        last = static_cast<unsigned int>(std::strtoul(argv[3], nullptr, 10));
+    }
+
+    // convert a chunk of events at a time to keep the memory flat
+    static constexpr unsigned int EVENTS_PER_CHUNK = 4096;
+    OutputSink output;
+    for (unsigned int event = first; event <= last; event += EVENTS_PER_CHUNK) {
+        unsigned int chunk_last = std::min(last, event + EVENTS_PER_CHUNK - 1);
+
+        output.clear();
+        if (!file->readEvents(event, chunk_last, output)) {
+            std::cerr << "ERROR: Events " << event << ".." << chunk_last << " are not in the file\n";
+            return -1;
+        }
+        std::cout.write(output.data(), output.size());
+
+        if (chunk_last == last) {
+            break;
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,172 @@
+#include "cpuTopology.hpp"
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <thread>
+
+// Detect the CPUs the process may run on and their NUMA nodes.
+CpuTopology CpuTopology::detect()
+{
+    CpuTopology topology;
+
+    // CPUs the process may run on, e.g. restricted by taskset or cgroups
+    std::vector<int> allowed;
+#ifdef __linux__
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if (sched_getaffinity(0, sizeof(set), &set) == 0) {
+        for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+            if (CPU_ISSET(cpu, &set)) {
+                allowed.push_back(cpu);
+            }
+        }
+    }
+#endif
+    if (allowed.empty()) {
+        for (unsigned int cpu = 0; cpu < std::max(1u, std::thread::hardware_concurrency()); ++cpu) {
+            allowed.push_back(static_cast<int>(cpu));
+        }
+    }
+
+    // CPUs of each NUMA node. Node numbers may have gaps, so a few missing
+    // nodes in a row end the search.
+    static constexpr int MAX_MISSING_NODES = 8;
+    for (int node = 0, missing = 0; missing < MAX_MISSING_NODES; ++node) {
+        std::ifstream file("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist");
+        std::string text;
+        std::vector<int> cpus;
+        if (!std::getline(file, text) || !parseCpuList(text, cpus)) {
+            ++missing;
+            continue;
+        }
+        missing = 0;
+        topology.nodes_.push_back(cpus);
+    }
+
+    if (topology.nodes_.empty()) {
+        topology.nodes_.push_back(allowed);
+    } else {
+        topology.restrict(allowed);
+    }
+
+    return topology;
+}
+
+// Parse a list of CPUs such as "0-3,8,10-11".
+bool CpuTopology::parseCpuList(const std::string& text, std::vector<int>& cpus)
+{
+    std::stringstream tokenizer(text);
+    std::string range;
+    while (std::getline(tokenizer, range, ',')) {
+        if (range.empty()) {
+            continue;
+        }
+
+        char* end;
+        long first = std::strtol(range.c_str(), &end, 10);
+        long last = first;
+        if (*end == '-') {
+            last = std::strtol(end + 1, &end, 10);
+        }
+        if (*end != '\0' || first < 0 || last < first || last >= MAX_CPUS) {
+            return false;
+        }
+
+        for (long cpu = first; cpu <= last; ++cpu) {
+            cpus.push_back(static_cast<int>(cpu));
+        }
+    }
+
+    return !cpus.empty();
+}
+
+// Returns the number of CPUs the process can use. A cgroup quota of e.g.
+// 150ms per 100ms period allows 2 busy threads, which is read from cpu.max
+// of cgroup v2 or from the cfs files of cgroup v1.
+unsigned int CpuTopology::getAvailableCpus()
+{
+    unsigned int cpus = static_cast<unsigned int>(detect().getCpus().size());
+
+    long quota = -1;
+    long period = 0;
+    std::ifstream cpu_max("/sys/fs/cgroup/cpu.max");
+    std::string quota_text;
+    if (cpu_max >> quota_text >> period) {
+        quota = quota_text == "max" ? -1 : std::strtol(quota_text.c_str(), nullptr, 10);
+    } else {
+        std::ifstream quota_file("/sys/fs/cgroup/cpu/cpu.cfs_quota_us");
+        std::ifstream period_file("/sys/fs/cgroup/cpu/cpu.cfs_period_us");
+        if (!(quota_file >> quota) || !(period_file >> period)) {
+            quota = -1;
+        }
+    }
+
+    if (quota > 0 && period > 0) {
+        unsigned int quota_cpus = static_cast<unsigned int>((quota + period - 1) / period);
+        cpus = std::min(cpus, std::max(1u, quota_cpus));
+    }
+
+    return std::max(1u, cpus);
+}
+
+// Pin the calling thread to the given CPUs.
+bool CpuTopology::pinCurrentThread(const std::vector<int>& cpus)
+{
+#ifdef __linux__
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (int cpu : cpus) {
+        if (cpu >= 0 && cpu < CPU_SETSIZE) {
+            CPU_SET(cpu, &set);
+        }
+    }
+    return CPU_COUNT(&set) > 0 && pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+    (void)cpus;
+    return false;
+#endif
+}
+
+// Read the affinity of the calling thread, which is not available on systems
+// without thread affinity.
+bool CpuTopology::supportsAffinity()
+{
+#ifdef __linux__
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    return pthread_getaffinity_np(pthread_self(), sizeof(set), &set) == 0 && CPU_COUNT(&set) > 0;
+#else
+    return false;
+#endif
+}
+
+// Keep only the given CPUs of the topology.
+void CpuTopology::restrict(const std::vector<int>& cpus)
+{
+    for (std::vector<int>& node : nodes_) {
+        node.erase(std::remove_if(node.begin(), node.end(), [&cpus](int cpu) {
+            return std::find(cpus.begin(), cpus.end(), cpu) == cpus.end();
+        }), node.end());
+    }
+
+    nodes_.erase(std::remove_if(nodes_.begin(), nodes_.end(), [](const std::vector<int>& node) {
+        return node.empty();
+    }), nodes_.end());
+}
+
+// Returns all CPUs, node by node.
+std::vector<int> CpuTopology::getCpus() const
+{
+    std::vector<int> cpus;
+    for (const std::vector<int>& node : nodes_) {
+        cpus.insert(cpus.end(), node.begin(), node.end());
+    }
+    return cpus;
+}
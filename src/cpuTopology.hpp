@@ -0,0 +1,56 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+// CPUs the process may run on, grouped by NUMA node. Used to pin the worker
+// threads of the executors so they don't migrate between cores and the
+// memory they touch first, e.g. their thread local random number engine and
+// result buffers, is allocated on their node.
+//
+// The NUMA nodes are read from sysfs on Linux. Machines without NUMA
+// information are treated as a single node and pinning is a no-op where
+// thread affinity isn't available.
+class CpuTopology
+{
+public:
+    // Detect the CPUs the process may run on and their NUMA nodes.
+    static CpuTopology detect();
+
+    // Parse a list of CPUs such as "0-3,8,10-11".
+    // returns: false if the list is not valid.
+    static bool parseCpuList(const std::string& text, std::vector<int>& cpus);
+
+    // Returns the number of CPUs the process can use, the CPUs it may run on
+    // limited by the CPU quota of its cgroup if any.
+    static unsigned int getAvailableCpus();
+
+    // Pin the calling thread to the given CPUs.
+    // returns: false if thread affinity isn't available.
+    static bool pinCurrentThread(const std::vector<int>& cpus);
+
+    // Returns whether threads have an affinity that can be read, without
+    // changing the one of the calling thread.
+    static bool supportsAffinity();
+
+    // Keep only the given CPUs of the topology, nodes left without CPUs
+    // are dropped.
+    void restrict(const std::vector<int>& cpus);
+
+    // Returns the CPUs of each NUMA node.
+    const std::vector<std::vector<int>>& getNodes() const {
+        return nodes_;
+    }
+
+    // Returns all CPUs, node by node.
+    std::vector<int> getCpus() const;
+
+private:
+    // limit on the CPU numbers of a list
+    static constexpr long MAX_CPUS = 65536;
+
+    CpuTopology() = default;
+
+    // CPUs of each NUMA node
+    std::vector<std::vector<int>> nodes_;
+};
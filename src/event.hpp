@@ -1,5 +1,7 @@
 #pragma once
 
+#include <cstddef>
+
 // Event is a full execution of a simulation. Each event is identified by an ID.
 // Additionally, each event has its own random number generator that can be
 // used to draw random numbers specific to this event. This allows for
@@ -11,6 +13,11 @@ public:
     explicit Event(unsigned int number, unsigned int seed)
         : number_(number), seed_(seed) {}
 
+    // Construct an event reading the given record of the input file of the
+    // simulation, which the event refers to without copying it.
+    explicit Event(unsigned int number, unsigned int seed, const char* record, size_t record_size)
+        : number_(number), seed_(seed), record_(record), record_size_(record_size) {}
+
     // Returns the number of this event.
     unsigned int getNumber() const {
         return number_;
@@ -21,10 +28,43 @@ public:
         return seed_;
     }
 
+    // Returns the record of this event in the input file of the simulation,
+    // null if the simulation has no input file. The record is mapped
+    // read only and stays valid for the whole run.
+    const char* getRecord() const {
+        return record_;
+    }
+
+    // Returns the number of characters of the record of this event.
+    size_t getRecordSize() const {
+        return record_size_;
+    }
+
 private:
     // the id of the event in the simulation.
     unsigned int number_ {0};
 
     // seed used for this event
     unsigned int seed_ {0};
+
+    // record of this event in the input file, if any
+    const char* record_ {nullptr};
+    size_t record_size_ {0};
+};
+
+class OutputSink;
+
+// Block of consecutive events executed together by modules implementing
+// the block interface, stored as a structure of arrays: the number, seed,
+// record and output of event i are numbers[i], seeds[i], records[i] with
+// record_sizes[i] characters and outputs[i].
+struct EventBlock {
+    // number of events in the block
+    size_t size {0};
+
+    const unsigned int* numbers {nullptr};
+    const unsigned int* seeds {nullptr};
+    const char* const* records {nullptr};
+    const size_t* record_sizes {nullptr};
+    OutputSink* outputs {nullptr};
 };
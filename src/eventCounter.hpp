@@ -0,0 +1,61 @@
+#pragma once
+
+#include "module.hpp"
+#include "moduleRegistry.hpp"
+#include "event.hpp"
+
+#include <cstdint>
+#include <iostream>
+
+// Example of a module accumulating state over the events. Every thread
+// counts the events it executes in its own instance without any lock, the
+// counts of the threads are added up when the run ends.
+class EventCounter final : public Module
+{
+public:
+    EventCounter() : Module("EventCounter") {
+    }
+
+    using Module::run;
+
+    // Start counting the events of the run.
+    void beginRun(unsigned int, unsigned int) override {
+        number_of_events_ = 0;
+    }
+
+    // Start counting the events of a thread.
+    void initializeThread(const Module&) override {
+        number_of_events_ = 0;
+    }
+
+    // Count the event, the results of the event are left as they are.
+    void run(const Event&, RandomEngine*, OutputSink&) override {
+        ++number_of_events_;
+    }
+
+    bool supportsBlocks() const override {
+        return true;
+    }
+
+    // Count the events of the block.
+    void runBlock(const EventBlock& events, MultiStreamEngine&) override {
+        number_of_events_ += events.size;
+    }
+
+    // Add the events counted by a thread.
+    void merge(const Module& thread_module) override {
+        number_of_events_ += static_cast<const EventCounter&>(thread_module).number_of_events_;
+    }
+
+    // Report the number of events of the run.
+    void finalize() override {
+        std::cout << "INFO: EventCounter counted " << number_of_events_ << " events\n";
+    }
+
+private:
+    // number of events executed by this instance, or by all threads once
+    // the run ended
+    uint64_t number_of_events_ {0};
+};
+
+REGISTER_MODULE(EventCounter);
@@ -0,0 +1,39 @@
+#include "executor.hpp"
+#include "partitionedPool.hpp"
+#include "threadPool.hpp"
+#include "workStealingPool.hpp"
+
+// Factory method for creating executors. Each new scheduling strategy should
+// declare it self here
+// params: scheduler - The name of the scheduling strategy to use.
+// returns: pointer to the executor or null if there is no such scheduler.
+std::unique_ptr<Executor> Executor::createExecutor(const std::string& scheduler,
+    size_t number_of_workers, size_t queue_capacity, Instrumentation* instrumentation,
+    const Placement& placement)
+{
+    std::unique_ptr<Executor> ptr = nullptr;
+
+    if (scheduler == "shared_queue" && placement.partitions.size() > 1) {
+        // one pool per partition, each with its share of the capacity
+        std::vector<std::unique_ptr<Executor>> partitions;
+        size_t first_worker = 0;
+        for (size_t size : placement.partitions) {
+            size_t capacity = (queue_capacity + placement.partitions.size() - 1) / placement.partitions.size();
+            std::vector<std::vector<int>> worker_cpus;
+            for (size_t i = first_worker; i < first_worker + size && i < placement.worker_cpus.size(); ++i) {
+                worker_cpus.push_back(placement.worker_cpus[i]);
+            }
+            partitions.emplace_back(new ThreadPool(size, capacity, instrumentation, worker_cpus));
+            first_worker += size;
+        }
+        ptr.reset(new PartitionedPool(std::move(partitions)));
+    } else if (scheduler == "shared_queue") {
+        ptr.reset(new ThreadPool(number_of_workers, queue_capacity, instrumentation,
+            placement.worker_cpus));
+    } else if (scheduler == "work_stealing") {
+        ptr.reset(new WorkStealingPool(number_of_workers, queue_capacity, instrumentation,
+            placement.worker_cpus));
+    }
+
+    return ptr;
+}
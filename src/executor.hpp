@@ -0,0 +1,74 @@
+#pragma once
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+class Instrumentation;
+
+// Abstract execution manager that allows for parallel execution of events.
+// Each task executes one event or a contiguous range of events and is
+// submitted to the executor and executed by one of its worker threads.
+// Implementations differ in how the tasks are handed out to the workers.
+class Executor
+{
+public:
+    using TaskType = std::function<void(void)>;
+
+    // Placement of the worker threads on the CPUs of the machine.
+    struct Placement {
+        // CPUs each worker is pinned to, workers without CPUs are not pinned
+        std::vector<std::vector<int>> worker_cpus;
+
+        // number of consecutive workers in each partition, e.g. one per NUMA
+        // node. Workers of different partitions don't share a queue. Empty
+        // means all workers are in one partition.
+        std::vector<size_t> partitions;
+    };
+
+    // Virtual destructor as all derived classes are handled with a base pointer.
+    virtual ~Executor() = default;
+
+    // Factory method for creating executors.
+    // params: scheduler - The name of the scheduling strategy to use.
+    //         number_of_workers - Number of worker threads, zero executes the
+    //              tasks on the caller thread.
+    //         queue_capacity - Maximum number of tasks waiting for execution,
+    //              zero means unbounded.
+    //         instrumentation - Optional instrumentation recording the busy
+    //              and idle time of the workers and their waits on locks.
+    //         placement - Optional placement of the workers on the CPUs.
+    // returns: pointer to the executor or null if there is no such scheduler.
+    static std::unique_ptr<Executor> createExecutor(const std::string& scheduler,
+        size_t number_of_workers, size_t queue_capacity,
+        Instrumentation* instrumentation = nullptr, const Placement& placement = Placement());
+
+    // Submits a task to be executed by the workers threads.
+    // The task executes the simulation of its events and is responsible for
+    // handing its result over, e.g. to an OrderedWriter.
+    //
+    // If there are no workers then the tasks will be executed in the
+    // client's thread. If the executor is at its capacity, this blocks the
+    // caller until the workers make progress.
+    virtual void submit(TaskType&& task) = 0;
+
+    // Change the number of workers executing the tasks, at most the number
+    // the executor was created with and zero to execute the following tasks
+    // on the caller thread. With adapt set the executor keeps tuning the
+    // number while tasks are submitted.
+    // returns: false if the executor can't change its number of workers,
+    //          its workers then keep executing the tasks.
+    virtual bool setActiveWorkers(size_t number_of_workers, bool adapt) {
+        (void)number_of_workers;
+        (void)adapt;
+        return false;
+    }
+
+    // Block waiting for the execution of all submitted events.
+    // Any tasks submitted after this call will not be executed.
+    virtual void execute() = 0;
+
+protected:
+    Executor() = default;
+};
@@ -0,0 +1,106 @@
+#include "inputFile.hpp"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+// Factory method for opening input files.
+std::unique_ptr<InputFile> InputFile::createInputFile(const std::string& path, size_t record_size)
+{
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        std::cerr << "ERROR: Couldn't open input file " << path << '\n';
+        return nullptr;
+    }
+
+    struct stat status;
+    std::unique_ptr<InputFile> file(new InputFile());
+    if (fstat(fd, &status) == 0 && status.st_size > 0) {
+        void* data = mmap(nullptr, static_cast<size_t>(status.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+        if (data != MAP_FAILED) {
+            file->data_ = static_cast<const char*>(data);
+            file->size_ = static_cast<size_t>(status.st_size);
+        }
+    }
+    close(fd);
+
+    file->record_size_ = record_size;
+    if (!file->data_ || !file->parse()) {
+        std::cerr << "ERROR: Invalid input file " << path << '\n';
+        return nullptr;
+    }
+
+    // the records are read in order, so the kernel may read ahead further
+    // than usual and drop the pages behind
+    madvise(const_cast<char*>(file->data_), file->size_, MADV_SEQUENTIAL);
+
+    return file;
+}
+
+InputFile::~InputFile()
+{
+    if (data_) {
+        munmap(const_cast<char*>(data_), size_);
+    }
+}
+
+// Parse the header and offsets of an indexed file.
+bool InputFile::parse()
+{
+    if (record_size_ > 0) {
+        records_ = data_;
+        number_of_records_ = size_ / record_size_;
+        return size_ % record_size_ == 0;
+    }
+
+    Header header;
+    if (size_ < sizeof(header)) {
+        return false;
+    }
+    std::memcpy(&header, data_, sizeof(header));
+    if (header.magic != MAGIC || header.version != VERSION
+            || header.number_of_records >= (size_ - sizeof(header)) / sizeof(uint64_t)) {
+        return false;
+    }
+
+    offsets_ = reinterpret_cast<const uint64_t*>(data_ + sizeof(header));
+    records_ = reinterpret_cast<const char*>(offsets_ + header.number_of_records + 1);
+    number_of_records_ = header.number_of_records;
+
+    // the offsets must be in order and the records within the file
+    size_t records_size = size_ - static_cast<size_t>(records_ - data_);
+    for (size_t record = 0; record < number_of_records_; ++record) {
+        if (offsets_[record] > offsets_[record + 1]) {
+            return false;
+        }
+    }
+    return offsets_[0] == 0 && offsets_[number_of_records_] <= records_size;
+}
+
+// Advise the kernel to read the records from the given one on ahead.
+void InputFile::readAhead(size_t record)
+{
+    if (record >= number_of_records_) {
+        return;
+    }
+
+    const char* data;
+    size_t size;
+    getRecord(record, data, size);
+    size_t start = static_cast<size_t>(data - data_);
+
+    // advise the next chunk once half of the advised part is left
+    if (start + READ_AHEAD_SIZE / 2 < read_ahead_end_ || read_ahead_end_ >= size_) {
+        return;
+    }
+
+    size_t page_size = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    size_t begin = std::max(start, read_ahead_end_) / page_size * page_size;
+    read_ahead_end_ = std::min(size_, begin + READ_AHEAD_SIZE);
+    madvise(const_cast<char*>(data_) + begin, read_ahead_end_ - begin, MADV_WILLNEED);
+}
@@ -0,0 +1,103 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+// Read only view of the input file of a simulation, holding a record of
+// recorded data per event, e.g. detector data or a row of a parameter table.
+// Event number n reads record n - 1. The file is memory mapped, so events
+// refer to their records without copying them, and the kernel is advised to
+// read the records of the events about to be executed ahead of the workers.
+//
+// Records are either of a fixed size given by the configuration, in which
+// case the file is just the concatenated records, or stored in the indexed
+// layout holding records of any size. Numbers are stored in the byte order
+// of the machine writing the file, which is checked by the magic number:
+//   header   - Header
+//   offsets  - uint64_t offset of every record followed by the end of the
+//              last record, relative to the start of the records
+//   records  - the characters of all records
+class InputFile
+{
+public:
+    // "FWIN" identifies an indexed input file
+    static constexpr uint32_t MAGIC = 0x4e495746;
+
+    // version of the indexed layout
+    static constexpr uint32_t VERSION = 1;
+
+    struct Header {
+        uint32_t magic;
+        uint32_t version;
+        uint64_t number_of_records;
+    };
+
+    // Factory method for opening input files.
+    // params: path - The path of the input file.
+    //         record_size - Size of every record of a file of fixed size
+    //         records, or 0 for an indexed file.
+    // returns: pointer to the file or null if it can't be read or is not a
+    //          valid input file.
+    static std::unique_ptr<InputFile> createInputFile(const std::string& path, size_t record_size);
+
+    // Unmaps the file.
+    ~InputFile();
+
+    // Copys are not allowed.
+    InputFile(const InputFile&) = delete;
+    InputFile& operator=(const InputFile&) = delete;
+
+    // Returns the number of records in the file.
+    size_t getNumberOfRecords() const {
+        return number_of_records_;
+    }
+
+    // Locate a record in the mapped file.
+    void getRecord(size_t record, const char*& data, size_t& size) const {
+        if (offsets_) {
+            data = records_ + offsets_[record];
+            size = static_cast<size_t>(offsets_[record + 1] - offsets_[record]);
+        } else {
+            data = records_ + record * record_size_;
+            size = record_size_;
+        }
+    }
+
+    // Advise the kernel to read the records from the given one on ahead,
+    // called in the order the records are used. Only advises once the
+    // records already advised are nearly used up, in chunks of at least
+    // READ_AHEAD_SIZE bytes.
+    void readAhead(size_t record);
+
+private:
+    InputFile() = default;
+
+    // Parse the header and offsets of an indexed file.
+    bool parse();
+
+    // number of bytes advised to be read at once
+    static constexpr size_t READ_AHEAD_SIZE = 4 << 20;
+
+    // start of the mapped file
+    const char* data_ {nullptr};
+
+    // size of the mapped file
+    size_t size_ {0};
+
+    // start of the records
+    const char* records_ {nullptr};
+
+    // offsets of the records of an indexed file, null for fixed size records
+    const uint64_t* offsets_ {nullptr};
+
+    // size of every record of a file of fixed size records
+    size_t record_size_ {0};
+
+    // number of records in the file
+    size_t number_of_records_ {0};
+
+    // end of the part of the file advised to be read so far
+    size_t read_ahead_end_ {0};
+};
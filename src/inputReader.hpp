@@ -0,0 +1,43 @@
+#pragma once
+
+#include "module.hpp"
+#include "moduleRegistry.hpp"
+#include "event.hpp"
+
+// Example of a module driven by the input file of the simulation. Appends
+// the record of every event to its results, read in place from the mapped
+// input file.
+class InputReader final : public Module
+{
+public:
+    InputReader() : Module("InputReader") {
+    }
+
+    using Module::run;
+
+    // Append the record of the event.
+    void run(const Event& e, RandomEngine*, OutputSink& output) override {
+        appendRecord(e.getRecord(), e.getRecordSize(), output);
+    }
+
+    bool supportsBlocks() const override {
+        return true;
+    }
+
+    // Append the records of all events of the block.
+    void runBlock(const EventBlock& events, MultiStreamEngine&) override {
+        for (size_t i = 0; i < events.size; ++i) {
+            appendRecord(events.records[i], events.record_sizes[i], events.outputs[i]);
+        }
+    }
+
+private:
+    void appendRecord(const char* record, size_t record_size, OutputSink& output) const {
+        output.append(name_);
+        output.append('_');
+        output.append(record, record_size);
+        output.append('\n');
+    }
+};
+
+REGISTER_MODULE(InputReader);
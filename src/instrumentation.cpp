@@ -0,0 +1,202 @@
+#include "instrumentation.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <iomanip>
+#include <utility>
+
+Histogram::Histogram() : buckets_(NUMBER_OF_BUCKETS, 0)
+{
+}
+
+// Add the values counted by another histogram.
+void Histogram::merge(const Histogram& other)
+{
+    for (size_t i = 0; i < NUMBER_OF_BUCKETS; ++i) {
+        buckets_[i] += other.buckets_[i];
+    }
+    count_ += other.count_;
+    sum_ += other.sum_;
+    if (other.max_ > max_) {
+        max_ = other.max_;
+    }
+}
+
+// Returns the value below which the given percentage of values fall. The
+// value is the upper bound of the bucket holding the percentile, capped by
+// the largest value counted.
+uint64_t Histogram::getPercentile(double percentile) const
+{
+    if (count_ == 0) {
+        return 0;
+    }
+
+    uint64_t rank = static_cast<uint64_t>(percentile / 100.0 * count_ + 0.5);
+    if (rank < 1) {
+        rank = 1;
+    }
+
+    uint64_t seen = 0;
+    for (size_t i = 0; i < NUMBER_OF_BUCKETS; ++i) {
+        seen += buckets_[i];
+        if (seen >= rank) {
+            uint64_t value = valueOf(i);
+            return value < max_ ? value : max_;
+        }
+    }
+
+    return max_;
+}
+
+// Returns the largest value counted by the given bucket.
+uint64_t Histogram::valueOf(size_t bucket)
+{
+    if (bucket < SUB_BUCKETS) {
+        return bucket;
+    }
+
+    uint64_t shift = (bucket - SUB_BUCKETS) / SUB_BUCKETS;
+    uint64_t top = SUB_BUCKETS + (bucket - SUB_BUCKETS) % SUB_BUCKETS;
+    return ((top + 1) << shift) - 1;
+}
+
+Instrumentation::Instrumentation(bool record_spans)
+    : record_spans_(record_spans), start_(now())
+{
+    static std::atomic<uint64_t> next_id {1};
+    id_ = next_id.fetch_add(1);
+}
+
+// Returns the statistics of the calling thread.
+Instrumentation::ThreadStatistics& Instrumentation::local(const char* role)
+{
+    // statistics the calling thread registered, by instrumentation id. A
+    // thread normally records for a single instrumentation at a time so
+    // the list stays short.
+    static thread_local std::vector<std::pair<uint64_t, ThreadStatistics*>> registered;
+
+    for (auto& entry : registered) {
+        if (entry.first == id_) {
+            return *entry.second;
+        }
+    }
+
+    // forget about instrumentations of older runs
+    if (registered.size() >= MAX_REGISTERED_PER_THREAD) {
+        registered.clear();
+    }
+
+    ThreadStatistics* statistics = new ThreadStatistics();
+    statistics->role = role;
+    statistics->record_spans = record_spans_;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        threads_.emplace_back(statistics);
+    }
+    registered.emplace_back(id_, statistics);
+
+    return *statistics;
+}
+
+// Returns the statistics of all threads merged.
+Instrumentation::ThreadStatistics Instrumentation::merge() const
+{
+    ThreadStatistics merged;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto& statistics : threads_) {
+        merged.event_time.merge(statistics->event_time);
+        if (merged.module_time.size() < statistics->module_time.size()) {
+            merged.module_time.resize(statistics->module_time.size());
+        }
+        for (size_t i = 0; i < statistics->module_time.size(); ++i) {
+            merged.module_time[i].merge(statistics->module_time[i]);
+        }
+        merged.queue_wait.merge(statistics->queue_wait);
+        merged.submit_time.merge(statistics->submit_time);
+        merged.result_time.merge(statistics->result_time);
+        merged.flush_time.merge(statistics->flush_time);
+        merged.lock_wait.merge(statistics->lock_wait);
+        merged.busy_time += statistics->busy_time;
+        merged.idle_time += statistics->idle_time;
+    }
+
+    return merged;
+}
+
+namespace {
+    // Write one line of the summary of a histogram.
+    void reportHistogram(std::ostream& output, const std::string& name, const Histogram& histogram)
+    {
+        if (histogram.getCount() == 0) {
+            return;
+        }
+
+        output << "INFO: " << name << ": count " << histogram.getCount()
+            << " total " << histogram.getSum() / 1000000.0 << " ms"
+            << " mean " << static_cast<uint64_t>(histogram.getMean()) << " ns"
+            << " p99 " << histogram.getPercentile(99) << " ns\n";
+    }
+}
+
+// Write a summary of the statistics.
+void Instrumentation::report(std::ostream& output, const std::vector<std::string>& module_names) const
+{
+    ThreadStatistics merged = merge();
+
+    reportHistogram(output, "submit", merged.submit_time);
+    reportHistogram(output, "queue wait", merged.queue_wait);
+    reportHistogram(output, "event", merged.event_time);
+    for (size_t i = 0; i < merged.module_time.size(); ++i) {
+        std::string name = i < module_names.size() ? module_names[i] : "module " + std::to_string(i);
+        reportHistogram(output, "module " + name, merged.module_time[i]);
+    }
+    reportHistogram(output, "result handoff", merged.result_time);
+    reportHistogram(output, "output flush", merged.flush_time);
+    reportHistogram(output, "executor lock wait", merged.lock_wait);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    size_t worker = 0;
+    for (auto& statistics : threads_) {
+        if (std::string(statistics->role) != "worker") {
+            continue;
+        }
+        output << "INFO: worker " << worker++ << ": busy " << statistics->busy_time / 1000000.0
+            << " ms idle " << statistics->idle_time / 1000000.0 << " ms\n";
+    }
+}
+
+// Write the recorded spans in the chrome trace event format.
+void Instrumentation::writeTrace(std::ostream& output) const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    // timestamps of the format are in microseconds
+    output << std::fixed << std::setprecision(3);
+    output << "{\"traceEvents\": [\n";
+
+    bool first = true;
+    for (size_t thread = 0; thread < threads_.size(); ++thread) {
+        const ThreadStatistics& statistics = *threads_[thread];
+
+        output << (first ? "" : ",\n") << "{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": "
+            << thread << ", \"args\": {\"name\": \"" << statistics.role << ' ' << thread << "\"}}";
+        first = false;
+
+        for (const Span& span : statistics.spans) {
+            output << ",\n{\"name\": \"" << span.name << "\", \"ph\": \"X\", \"pid\": 1, \"tid\": " << thread
+                << ", \"ts\": " << (span.start - start_) / 1000.0
+                << ", \"dur\": " << span.duration / 1000.0
+                << ", \"args\": {\"id\": " << span.id << "}}";
+        }
+    }
+
+    output << "\n]}\n";
+}
+
+// Returns the time of a monotonic clock in nanoseconds.
+int64_t Instrumentation::now()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
@@ -0,0 +1,230 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// Histogram of durations in nanoseconds with a bounded relative error. Values
+// are counted in buckets of 32 sub buckets per power of two, which keeps
+// the error of the reported percentiles within about 3% for any value.
+// Histograms of different threads are merged by adding their buckets.
+class Histogram
+{
+public:
+    Histogram();
+
+    // Count a value.
+    void record(uint64_t value) {
+        ++buckets_[bucketOf(value)];
+        ++count_;
+        sum_ += value;
+        if (value > max_) {
+            max_ = value;
+        }
+    }
+
+    // Add the values counted by another histogram.
+    void merge(const Histogram& other);
+
+    // Returns the number of values counted.
+    uint64_t getCount() const {
+        return count_;
+    }
+
+    // Returns the sum of the values counted.
+    uint64_t getSum() const {
+        return sum_;
+    }
+
+    // Returns the largest value counted.
+    uint64_t getMax() const {
+        return max_;
+    }
+
+    // Returns the mean of the values counted.
+    double getMean() const {
+        return count_ > 0 ? static_cast<double>(sum_) / count_ : 0;
+    }
+
+    // Returns the value below which the given percentage of values fall.
+    uint64_t getPercentile(double percentile) const;
+
+private:
+    // number of bits of a value resolved within a power of two
+    static constexpr int SUB_BUCKET_BITS = 5;
+
+    // number of sub buckets per power of two
+    static constexpr uint64_t SUB_BUCKETS = 1 << SUB_BUCKET_BITS;
+
+    // number of buckets needed to cover all 64 bit values
+    static constexpr size_t NUMBER_OF_BUCKETS = (64 - SUB_BUCKET_BITS + 1) * SUB_BUCKETS;
+
+    // Returns the bucket counting the given value.
+    static size_t bucketOf(uint64_t value) {
+        if (value < SUB_BUCKETS) {
+            return static_cast<size_t>(value);
+        }
+
+        int highest_bit = 63 - __builtin_clzll(value);
+        int shift = highest_bit - SUB_BUCKET_BITS;
+        return static_cast<size_t>(SUB_BUCKETS + shift * SUB_BUCKETS + ((value >> shift) - SUB_BUCKETS));
+    }
+
+    // Returns the largest value counted by the given bucket.
+    static uint64_t valueOf(size_t bucket);
+
+    // number of values per bucket
+    std::vector<uint64_t> buckets_;
+
+    // number of values counted
+    uint64_t count_ {0};
+
+    // sum of the values counted
+    uint64_t sum_ {0};
+
+    // largest value counted
+    uint64_t max_ {0};
+};
+
+// Low overhead timing instrumentation of a simulation run. Every thread
+// records into its own statistics, so nothing is shared between threads on
+// the hot path, and the statistics of all threads are merged at the end of
+// the run. Optionally the threads also record spans of their work that are
+// exported as a chrome trace.
+class Instrumentation
+{
+public:
+    // Interval of work done by a thread, exported to the trace.
+    struct Span {
+        // name of the work, a string literal
+        const char* name;
+
+        // identifier of the work, e.g. the batch number
+        uint64_t id;
+
+        // start time in nanoseconds
+        int64_t start;
+
+        // duration in nanoseconds
+        int64_t duration;
+    };
+
+    // Statistics recorded by one thread.
+    struct ThreadStatistics {
+        // role of the thread, e.g. main, worker or writer
+        const char* role {"thread"};
+
+        // whether spans are recorded
+        bool record_spans {false};
+
+        // time to execute all modules of an event
+        Histogram event_time;
+
+        // time to execute each module for an event, indexed by module
+        std::vector<Histogram> module_time;
+
+        // time a task waited in the executor queue before being executed
+        Histogram queue_wait;
+
+        // time the producer spent reserving and submitting a task,
+        // including the time it was blocked by back pressure
+        Histogram submit_time;
+
+        // time handing the result of a task to the writer
+        Histogram result_time;
+
+        // time writing a run of results to the output stream
+        Histogram flush_time;
+
+        // time waiting to acquire the executor lock when it was contended
+        Histogram lock_wait;
+
+        // nanoseconds a worker spent executing tasks
+        int64_t busy_time {0};
+
+        // nanoseconds a worker spent looking or waiting for tasks
+        int64_t idle_time {0};
+
+        // work done by the thread, if spans are recorded
+        std::vector<Span> spans;
+
+        // Record the time of the given module for an event.
+        void recordModule(size_t module, uint64_t value) {
+            if (module >= module_time.size()) {
+                module_time.resize(module + 1);
+            }
+            module_time[module].record(value);
+        }
+
+        // Record a span of work if spans are recorded.
+        void recordSpan(const char* name, uint64_t id, int64_t start, int64_t end) {
+            if (record_spans) {
+                spans.push_back(Span {name, id, start, end - start});
+            }
+        }
+    };
+
+    // Create an instrumentation, recording spans for a trace if asked to.
+    explicit Instrumentation(bool record_spans = false);
+
+    // Copys are not allowed.
+    Instrumentation(const Instrumentation&) = delete;
+    Instrumentation& operator=(const Instrumentation&) = delete;
+
+    // Returns the statistics of the calling thread. Registers them with the
+    // given role on the first call of a thread, which is the only time a
+    // lock is taken.
+    ThreadStatistics& local(const char* role = "thread");
+
+    // Returns the statistics of all threads merged. Must be called once the
+    // threads stopped recording.
+    ThreadStatistics merge() const;
+
+    // Write a summary of the statistics, using the given names for the
+    // modules. Must be called once the threads stopped recording.
+    void report(std::ostream& output, const std::vector<std::string>& module_names) const;
+
+    // Write the recorded spans in the chrome trace event format, which can
+    // be loaded in chrome://tracing or https://ui.perfetto.dev. Must be
+    // called once the threads stopped recording.
+    void writeTrace(std::ostream& output) const;
+
+    // Lock the given lock, recording the time spent waiting for it into the
+    // statistics if the lock is contended. Statistics may be null.
+    static void lock(std::unique_lock<std::mutex>& lock, ThreadStatistics* statistics) {
+        if (!statistics) {
+            lock.lock();
+        } else if (!lock.try_lock()) {
+            int64_t start = now();
+            lock.lock();
+            statistics->lock_wait.record(static_cast<uint64_t>(now() - start));
+        }
+    }
+
+    // Returns the time of a monotonic clock in nanoseconds.
+    static int64_t now();
+
+private:
+    // number of instrumentations a thread remembers before it forgets those
+    // of older runs
+    static constexpr size_t MAX_REGISTERED_PER_THREAD = 16;
+
+    // unique identifier of this object, used by the threads to find their
+    // statistics even if another object is later created at the same address
+    uint64_t id_ {0};
+
+    // whether the threads record spans
+    bool record_spans_ {false};
+
+    // time the instrumentation was created at, the origin of the trace
+    int64_t start_ {0};
+
+    // mutex protecting the list of statistics
+    mutable std::mutex mutex_;
+
+    // statistics of every thread that recorded something
+    std::vector<std::unique_ptr<ThreadStatistics>> threads_;
+};
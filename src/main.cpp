@@ -1,7 +1,12 @@
 #include "configuration.hpp"
 #include "simulation.hpp"
+#include "instrumentation.hpp"
+#include "server.hpp"
+#include "sweep.hpp"
 
+#include <fstream>
 #include <iostream>
+#include <sstream>
 #include <chrono>
 using namespace std::chrono;
 using std::cout;
@@ -13,32 +18,137 @@ int main(int argc, char* argv[]) {
 	bool verbose = false;
 	std::string filename;
 
+	// options precede the configuration file
+	bool resume = false;
+	bool sweep = false;
+	bool serve = false;
+	std::string socket_path;
+	std::string output_path;
+	unsigned int shard = 0;
+	unsigned int number_of_shards = 0;
+	for (int i = 1; i < argc; ++i) {
+		std::string argument(argv[i]);
+		char separator = 0;
+		if (argument == "-v" && i + 1 < argc) {
+			verbose = true;
+		} else if (argument == "--resume" && i + 1 < argc) {
+			resume = true;
+		} else if (argument == "--sweep" && i + 1 < argc) {
+			sweep = true;
+		} else if (argument == "--serve" && i + 1 < argc) {
+			serve = true;
+		} else if (argument == "--submit" && i + 2 < argc) {
+			socket_path = argv[++i];
+		} else if (argument == "--output" && i + 2 < argc) {
+			output_path = argv[++i];
+		} else if (argument == "--shard" && i + 2 < argc) {
+			std::istringstream(argv[++i]) >> shard >> separator >> number_of_shards;
+			if (separator != '/' || number_of_shards == 0) {
+				filename.clear();
+				break;
+			}
+		} else if (i + 1 == argc) {
+			filename = argument;
+		} else {
+			filename.clear();
+			break;
+		}
+	}
+
+	// standard out is only written by this thread and results bypass it, so
+	// it doesn't need to be synchronized with C stdio. The simulations of a
+	// sweep or of a server print their messages from several threads.
+	if (!sweep && !serve) {
+		std::ios::sync_with_stdio(false);
+	}
+
 	cout << "Framework ..." << endl;
 
-	if (argc != 2) {
-		if (argc == 3 && std::string(argv[1]) == "-v") {
-			verbose = true;
-			filename = std::string(argv[2]);
+	bool submit = !socket_path.empty();
+	if (filename.empty() || (sweep && number_of_shards > 0) || (serve && (sweep || submit || resume || number_of_shards > 0))
+			|| (submit && (sweep || resume || number_of_shards > 0)) || (!output_path.empty() && !submit)) {
+		std::cerr << "ERROR: Incorrect arguments\n";
+		std::cerr << "Usage: framework [-v] [--resume] [--shard k/N] /path/to/configuration.file\n";
+		std::cerr << "       framework [-v] [--resume] --sweep /path/to/sweep.file\n";
+		std::cerr << "       framework --serve /path/to/socket\n";
+		std::cerr << "       framework [-v] --submit /path/to/socket [--output /path/to/output.file] /path/to/configuration.file\n";
+		return return_code;
+	}
+
+	// keep the workers and modules resident and run the jobs submitted
+	// over the socket
+	if (serve) {
+		std::unique_ptr<Server> server = Server::createServer(filename);
+		if (server && server->run()) {
+			return_code = 0;
+		}
+		std::cout << "Terminating ..." << endl;
+
+		return return_code;
+	}
+
+	// run a simulation on a server and write the results it streams back
+	if (submit) {
+		high_resolution_clock::time_point start_time = high_resolution_clock::now();
+		bool succeeded = Server::submit(socket_path, filename, output_path);
+		high_resolution_clock::time_point finish_time = high_resolution_clock::now();
+
+		if (succeeded) {
+			if (verbose) {
+				cout << "INFO: Finished job in "
+					<< duration_cast<milliseconds>(finish_time - start_time).count() << " ms\n";
+			}
+			return_code = 0;
+		}
+		std::cout << "Terminating ..." << endl;
+
+		return return_code;
+	}
+
+	// run all simulations of a sweep file in this process
+	if (sweep) {
+		std::unique_ptr<Sweep> simulations = Sweep::createSweep(filename);
+		if (simulations) {
+			simulations->setResume(resume);
+
+			high_resolution_clock::time_point start_time = high_resolution_clock::now();
+			bool succeeded = simulations->run();
+			high_resolution_clock::time_point finish_time = high_resolution_clock::now();
+
+			if (verbose) {
+				cout << "INFO: Finished sweep of " << simulations->getNumberOfRuns() << " simulations in "
+					<< duration_cast<milliseconds>(finish_time - start_time).count() << " ms\n";
+			}
+
+			if (succeeded) {
+				return_code = 0;
+			}
 		} else {
-			std::cerr << "ERROR: Incorrect arguments\n";
-			std::cerr << "Usage: framework /path/to/configuration.file\n";
-			return return_code;
+			std::cerr << "Incorrect sweep file...\n";
 		}
-	} else {
-		filename = std::string(argv[1]);
+		std::cout << "Terminating ..." << endl;
+
+		return return_code;
 	}
 
 	// read and check configuration file correctness
 	Configuration config = Configuration::createConfiguration(filename);
-	if (config.correct()) {
+	if (config.correct() && (number_of_shards == 0 || config.selectShard(shard, number_of_shards))) {
 
 		// initialize the simulation given the configuration
 		Simulation simulation(config);
+		simulation.setResume(resume);
 		if (simulation.init()) {
+			// optionally record timing statistics of the simulation
+			Instrumentation instrumentation(!config.getTraceFile().empty());
+			if (config.useInstrumentation()) {
+				simulation.setInstrumentation(&instrumentation);
+			}
+
 			high_resolution_clock::time_point start_time = high_resolution_clock::now();
 			
 			// execute the simulation
-			simulation.run();
+			bool succeeded = simulation.run();
 			
 			high_resolution_clock::time_point finish_time = high_resolution_clock::now();
 
@@ -47,11 +157,25 @@ int main(int argc, char* argv[]) {
 			// optionally output runtime information
 			if (verbose) {
 				cout << "INFO: Finished simulation with " 
-					<< config.getNumberOfEvents() << " events in " << duration << " ms\n";
+					<< config.getLastEvent() - config.getFirstEvent() + 1 << " events in " << duration << " ms\n";
 			}
 
-			// exit normally
-			return_code = 0;
+			// report where the time was spent
+			if (config.useInstrumentation()) {
+				instrumentation.report(cout, config.getModuleNames());
+			}
+			if (!config.getTraceFile().empty()) {
+				std::ofstream trace_file(config.getTraceFile());
+				instrumentation.writeTrace(trace_file);
+				if (!trace_file) {
+					std::cerr << "ERROR: Couldn't write trace file " << config.getTraceFile() << '\n';
+				}
+			}
+
+			// exit normally once all results are written
+			if (succeeded) {
+				return_code = 0;
+			}
 		}
 	} else {
 		std::cerr << "Incorrect configuration file...\n";
@@ -0,0 +1,333 @@
+#include "binaryFormat.hpp"
+#include "resultFile.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <regex>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+    // Returns whether the file starts with the magic number of binary
+    // result files.
+    bool isBinary(const std::string& path)
+    {
+        std::ifstream file(path, std::ios::binary);
+        uint32_t magic = 0;
+        file.read(reinterpret_cast<char*>(&magic), sizeof(magic));
+        return file && magic == BinaryFormat::FILE_MAGIC;
+    }
+
+    // Merge binary result files of consecutive shards. The blocks are copied
+    // as they are and a new index locates them in the merged file.
+    bool mergeBinary(const std::vector<std::string>& paths, std::ostream& output)
+    {
+        std::vector<std::string> module_names;
+        std::string index;
+        uint64_t offset = 0;
+        bool have_events = false;
+        unsigned int next_event = 0;
+
+        for (size_t i = 0; i < paths.size(); ++i) {
+            std::unique_ptr<ResultFile> file = ResultFile::createResultFile(paths[i]);
+            if (!file) {
+                return false;
+            }
+
+            if (i == 0) {
+                module_names = file->getModuleNames();
+                offset = BinaryFormat::writeFileHeader(output, module_names);
+            } else if (file->getModuleNames() != module_names) {
+                std::cerr << "ERROR: Shard " << paths[i] << " has different modules\n";
+                return false;
+            }
+
+            for (size_t block = 0; block < file->getNumberOfBlocks(); ++block) {
+                BinaryFormat::IndexEntry entry = file->getIndexEntry(block);
+                if (have_events && entry.first_event != next_event) {
+                    std::cerr << "ERROR: Shard " << paths[i]
+                        << " doesn't continue the events of the previous shard\n";
+                    return false;
+                }
+
+                const char* data;
+                size_t size;
+                if (!file->getBlock(block, data, size)) {
+                    std::cerr << "ERROR: Invalid result file " << paths[i] << '\n';
+                    return false;
+                }
+                output.write(data, size);
+
+                entry.offset = offset;
+                index.append(reinterpret_cast<const char*>(&entry), sizeof(entry));
+                offset += size;
+                next_event = entry.first_event + entry.number_of_events;
+                have_events = true;
+            }
+        }
+
+        BinaryFormat::Footer footer {offset, index.size() / sizeof(BinaryFormat::IndexEntry),
+            BinaryFormat::FOOTER_MAGIC, BinaryFormat::VERSION};
+        output.write(index.data(), index.size());
+        output.write(reinterpret_cast<const char*>(&footer), sizeof(footer));
+        return static_cast<bool>(output);
+    }
+
+    // Message printed when a run ends that reports totals over the events of
+    // the run. The numbers of the shards are added up, except durations
+    // marked by a '>' in the operations, which are the longest of the shards
+    // as they run side by side.
+    struct CountMessage {
+        std::regex pattern;
+        const char* operations;
+    };
+
+    const std::vector<CountMessage>& getCountMessages()
+    {
+        static const std::vector<CountMessage> messages {
+            {std::regex("INFO: EventCounter counted ([0-9]+) events"), "+"},
+            {std::regex("INFO: Finished simulation with ([0-9]+) events in ([0-9]+) ms"), "+>"},
+            {std::regex("INFO: Took ([0-9]+) of ([0-9]+) module results from the result cache"), "++"}
+        };
+        return messages;
+    }
+
+    // Returns the index of the count message matched by the line, or the
+    // number of count messages if it is no count.
+    size_t findCountMessage(const std::string& line, std::smatch& match)
+    {
+        const std::vector<CountMessage>& messages = getCountMessages();
+        for (size_t m = 0; m < messages.size(); ++m) {
+            if (std::regex_match(line, match, messages[m].pattern)) {
+                return m;
+            }
+        }
+        return messages.size();
+    }
+
+    // Merge the messages after the last event of every shard with events.
+    // Counts are merged line by line in the order of the first shard, so the
+    // shards need the same count messages. Other messages are kept if all
+    // shards print them, messages of a shard alone such as its timing
+    // statistics don't describe the merged run and are left out.
+    // returns: false if the shards print different count messages.
+    bool mergeTrailers(const std::vector<std::vector<std::string>>& trailers, std::string& merged)
+    {
+        merged.clear();
+        if (trailers.empty()) {
+            return true;
+        }
+
+        // the count messages of every shard in order
+        std::vector<std::vector<std::string>> counts(trailers.size());
+        for (size_t i = 0; i < trailers.size(); ++i) {
+            std::smatch match;
+            for (const std::string& line : trailers[i]) {
+                if (findCountMessage(line, match) < getCountMessages().size()) {
+                    counts[i].push_back(line);
+                }
+            }
+            if (counts[i].size() != counts.front().size()) {
+                return false;
+            }
+        }
+
+        size_t next_count = 0;
+        for (const std::string& line : trailers.front()) {
+            std::smatch match;
+            size_t message = findCountMessage(line, match);
+            if (message == getCountMessages().size()) {
+                bool everywhere = true;
+                for (size_t i = 1; i < trailers.size() && everywhere; ++i) {
+                    everywhere = std::find(trailers[i].begin(), trailers[i].end(), line) != trailers[i].end();
+                }
+                if (everywhere) {
+                    merged += line + '\n';
+                }
+                continue;
+            }
+
+            // the same message of every shard, holding its own numbers
+            const char* operations = getCountMessages()[message].operations;
+            std::vector<uint64_t> numbers(match.size() - 1, 0);
+            for (size_t i = 0; i < trailers.size(); ++i) {
+                std::smatch shard_match;
+                if (findCountMessage(counts[i][next_count], shard_match) != message) {
+                    return false;
+                }
+                for (size_t n = 0; n < numbers.size(); ++n) {
+                    uint64_t number = std::strtoull(shard_match.str(n + 1).c_str(), nullptr, 10);
+                    numbers[n] = (operations[n] == '>') ? std::max(numbers[n], number) : numbers[n] + number;
+                }
+            }
+            ++next_count;
+
+            std::string merged_line;
+            size_t position = 0;
+            for (size_t n = 0; n < numbers.size(); ++n) {
+                merged_line += line.substr(position, match.position(n + 1) - position) + std::to_string(numbers[n]);
+                position = match.position(n + 1) + match.length(n + 1);
+            }
+            merged += merged_line + line.substr(position) + '\n';
+        }
+        return true;
+    }
+
+    // Read the standard out of a shard, checking its messages before the
+    // first event are the preamble and its events continue the ones before.
+    // The events are copied to the output if any, and the lines after the
+    // last event are returned as the trailer, the messages of a shard
+    // without events are returned as messages. Every event ends with an
+    // empty line.
+    // returns: false if the shard can't be read or doesn't fit the others.
+    bool readShard(const std::string& path, std::ostream* output, std::string& preamble, bool& have_events,
+        unsigned int& next_event, bool& in_events, std::vector<std::string>& trailer, std::string& messages)
+    {
+        static const char EVENT_PREFIX[] = "event #";
+        static const size_t EVENT_PREFIX_SIZE = sizeof(EVENT_PREFIX) - 1;
+
+        std::ifstream file(path);
+        if (!file) {
+            std::cerr << "ERROR: Couldn't open shard " << path << '\n';
+            return false;
+        }
+
+        std::string line;
+        std::string pending;
+        in_events = false;
+        trailer.clear();
+        messages.clear();
+        while (std::getline(file, line)) {
+            bool event_line = line.compare(0, EVENT_PREFIX_SIZE, EVENT_PREFIX) == 0;
+            if (!in_events && !event_line) {
+                messages += line;
+                messages += '\n';
+                continue;
+            }
+
+            if (!in_events) {
+                // shards of the same simulation print the same messages
+                if (!have_events) {
+                    preamble = messages;
+                } else if (messages != preamble) {
+                    std::cerr << "ERROR: Shard " << path << " was run with a different configuration\n";
+                    return false;
+                }
+                in_events = true;
+            }
+
+            if (event_line) {
+                unsigned int number = static_cast<unsigned int>(
+                    std::strtoul(line.c_str() + EVENT_PREFIX_SIZE, nullptr, 10));
+                if (have_events && number != next_event) {
+                    std::cerr << "ERROR: Shard " << path << " doesn't continue the events of the previous shard\n";
+                    return false;
+                }
+                next_event = number + 1;
+                have_events = true;
+            }
+
+            pending += line;
+            pending += '\n';
+            if (line.empty()) {
+                if (output) {
+                    *output << pending;
+                }
+                pending.clear();
+            }
+        }
+
+        // the lines after the last event, or no trailer without events
+        if (in_events) {
+            std::istringstream lines(pending);
+            while (std::getline(lines, line)) {
+                trailer.push_back(line);
+            }
+        }
+        return true;
+    }
+
+    // Merge the standard out of consecutive shards. The messages before the
+    // first event are taken from the first shard with events and the ones
+    // after the last event are merged over the shards with events, see
+    // mergeTrailers. The shards are checked before any output is written,
+    // then the events of all shards are copied in between.
+    bool mergeText(const std::vector<std::string>& paths, std::ostream& output)
+    {
+        std::string preamble;
+        std::string first_messages;
+        std::string messages;
+        bool have_events = false;
+        unsigned int next_event = 0;
+        bool in_events = false;
+        std::vector<std::string> trailer;
+        std::vector<std::vector<std::string>> trailers;
+        for (size_t i = 0; i < paths.size(); ++i) {
+            if (!readShard(paths[i], nullptr, preamble, have_events, next_event, in_events, trailer, messages)) {
+                return false;
+            }
+            if (i == 0) {
+                first_messages = messages;
+            }
+            if (in_events) {
+                trailers.push_back(trailer);
+            }
+        }
+
+        // without events all messages of the first shard are kept
+        if (!have_events) {
+            output << first_messages;
+            return static_cast<bool>(output);
+        }
+
+        std::string merged_trailer;
+        if (!mergeTrailers(trailers, merged_trailer)) {
+            std::cerr << "ERROR: Shards end with different messages\n";
+            return false;
+        }
+
+        output << preamble;
+        have_events = false;
+        for (const std::string& path : paths) {
+            if (!readShard(path, &output, preamble, have_events, next_event, in_events, trailer, messages)) {
+                return false;
+            }
+        }
+        output << merged_trailer;
+        return static_cast<bool>(output);
+    }
+}
+
+// Merges the results of the shards of a simulation into the results of a
+// single process, see the option --shard of the framework.
+//
+// Usage: framework_merge shard1 shard2 ...
+//
+// The shards are given in order and are either the standard out of the
+// framework or binary result files. The merged results are written to
+// standard out. Text is merged into exactly the standard out of a single
+// process. Binary files are merged into a result file holding the same
+// events, with the blocks of the shards.
+int main(int argc, char* argv[])
+{
+    if (argc < 2) {
+        std::cerr << "ERROR: Incorrect arguments\n";
+        std::cerr << "Usage: framework_merge shard1 shard2 ...\n";
+        return -1;
+    }
+
+    std::ios::sync_with_stdio(false);
+
+    std::vector<std::string> paths(argv + 1, argv + argc);
+    bool merged = isBinary(paths[0]) ? mergeBinary(paths, std::cout) : mergeText(paths, std::cout);
+    if (!merged) {
+        return -1;
+    }
+
+    return 0;
+}
@@ -1,37 +1,26 @@
 #include "module.hpp"
 #include "event.hpp"
+#include "outputSink.hpp"
+#include "moduleRegistry.hpp"
 
-// modules are statically linked to the executable for simplicity
+// modules are statically linked to the executable for simplicity. Including
+// them here runs their registration in the module registry.
 #include "module1.hpp"
 #include "module2.hpp"
 #include "module3.hpp"
 #include "module4.hpp"
 #include "module5.hpp"
+#include "eventCounter.hpp"
+#include "inputReader.hpp"
 
-#include <iostream>
-
-// Factory method for creating modules. Each new module should
-// declare it self here
+// Factory method for creating modules. Modules register themselves in the
+// ModuleRegistry using the REGISTER_MODULE macro in their header.
 // params: name - The name of module to create.
 // returns: pointer to the correct class of the module request or null
 // 		if there is no such module.
 std::shared_ptr<Module> Module::createModule(const std::string& name )
 {
-    std::shared_ptr<Module> ptr = nullptr;
-
-    if (name == "Module1") {
-        ptr = std::make_shared<Module1>();
-    } else if (name == "Module2") {
-        ptr = std::make_shared<Module2>();
-    } else if (name == "Module3") {
-        ptr = std::make_shared<Module3>();
-    } else if (name == "Module4") {
-        ptr = std::make_shared<Module4>();
-    } else if (name == "Module5") {
-        ptr = std::make_shared<Module5>();
-    }
-
-    return ptr;
+    return ModuleRegistry::instance().create(name);
 }
 
 // Main method for each module. This method is called in each event to
@@ -39,23 +28,55 @@ std::shared_ptr<Module> Module::createModule(const std::string& name )
 // Return string of it's name with 2 random numbers drawn from event's
 // random number generator.
 // params: event - Current event of the simulation.
+//         random_engine - Random number engine seeded for the current event.
 // Note: This should be pure virtual but since all modules of this example
 // do exactly the same thing, for simplicity I keep it.
-std::string Module::run(const Event& e, std::mt19937* random_engine)
+std::string Module::run(const Event& e, RandomEngine* random_engine)
 {
-    // draw two random numbers
-    unsigned int n1, n2;
-
-    // need to be carefull since the underlying random number engine
-    // is not thread safe
-    {
-        //std::lock_guard<std::mutex> lock(mutex_);
-        //random_engine_.seed(e.getSeed());
-        n1 = (*random_engine)();
-        n2 = (*random_engine)();
-    }
+    // draw two random numbers from the engine of the event, which is not
+    // shared with other threads
+    unsigned int n1 = (*random_engine)();
+    unsigned int n2 = (*random_engine)();
 
     std::string s = name_ + "_" + std::to_string(n1)
                     + "_" + std::to_string(n2) + '\n';
     return s;
 }
+
+// Main method for each module appending its result to the output of the
+// event. By default it adapts the modules implementing the string version
+// of run by appending the string they return.
+// params: event - Current event of the simulation.
+//         output - Output of the current event.
+void Module::run(const Event& e, RandomEngine* random_engine, OutputSink& output)
+{
+    output.append(run(e, random_engine));
+}
+
+// Execute the module for a block of events. By default the events are
+// executed one at a time, each drawing from its own stream.
+// params: events - The events of the block.
+//         random_streams - Random number streams of the events.
+void Module::runBlock(const EventBlock& events, MultiStreamEngine& random_streams)
+{
+    for (size_t i = 0; i < events.size; ++i) {
+        Event e(events.numbers[i], events.seeds[i], events.records[i], events.record_sizes[i]);
+        run(e, &random_streams.getStream(i), events.outputs[i]);
+    }
+}
+
+// Draw two random numbers for every event of the block, all streams at
+// once, and append them to the outputs of the events.
+// params: events - The events of the block.
+//         random_streams - Random number streams of the events.
+void Module::writeRandomNumbers(const EventBlock& events, MultiStreamEngine& random_streams) const
+{
+    uint32_t numbers[2][MultiStreamEngine::LANES];
+    random_streams.draw(numbers[0]);
+    random_streams.draw(numbers[1]);
+
+    for (size_t i = 0; i < events.size; ++i) {
+        uint32_t values[2] = {numbers[0][i], numbers[1][i]};
+        events.outputs[i].appendValues(name_, values, 2);
+    }
+}
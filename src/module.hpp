@@ -1,40 +1,152 @@
 #pragma once
 
-#include <random>
+#include "randomEngine.hpp"
+#include "multiStreamEngine.hpp"
+#include "outputSink.hpp"
+
 #include <string>
 #include <memory>
-#include <mutex>
 
 class Event;
+struct EventBlock;
 
 // Abstract module in the simulation. Module implementations must be derived
 // from this class. Every module executes a given event where events can be
-// executed in parallel, and as such, each module has it's own mutex which
-// should be used when accessing the shared resource or state that is not
-// thread safe.
+// executed in parallel. Each thread executing events gets its own instance
+// of the module for every run, so state accumulated over the events, e.g. a
+// histogram or a counter, needs no lock. The instances of the threads are
+// merged into the module loaded by the simulation once the run ends.
+//
+// The simulation calls the hooks of the modules in this order:
+//     initialize          once when the simulation loads the module
+//     beginRun            before the events of a run
+//     initializeThread    on the instance of each thread before its events
+//     finalizeThread      on the instance of each thread after the run
+//     merge               with the instance of each thread after the run
+//     finalize            after the instances of the threads were merged
 class Module {
 public:
 
 	// Virtual destructor as all derived classes are handled with a base pointer.
 	virtual ~Module() = default;
 
-	// Factory method for creating modules.
+	// Factory method for creating modules. Modules are looked up by name in
+	// the ModuleRegistry where they register themselves.
 	// params: name - The name of module to create.
 	// returns: pointer to the correct class of the module request or null
 	// 		if there is no such module.
 	static std::shared_ptr<Module> createModule(const std::string& name);
 
+	// Returns the unique name of the module.
+	const std::string& getName() const {
+		return name_;
+	}
+
+	// Initialize the module loaded by the simulation, e.g. read its tables.
+	// returns: false if the module can't be used, which fails the
+	// 		initialization of the simulation.
+	virtual bool initialize() {
+		return true;
+	}
+
+	// Prepare the module loaded by the simulation for a run of events. The
+	// module may be reused by the following simulations of a sweep.
+	// params: first_event - Number of the first event of the run.
+	//         number_of_events - Number of events of the run.
+	virtual void beginRun(unsigned int first_event, unsigned int number_of_events) {
+		(void)first_event;
+		(void)number_of_events;
+	}
+
+	// Initialize the instance of a thread, called on the thread before it
+	// executes the events of a run. Instances are reused by the following
+	// simulations of a sweep, so this also resets their state.
+	// params: module - The module loaded by the simulation, initialized and
+	// 		prepared for the run, e.g. to share its read only tables.
+	virtual void initializeThread(const Module& module) {
+		(void)module;
+	}
+
+	// Complete the state of the instance of a thread after the last event
+	// of the run, before it's merged.
+	virtual void finalizeThread() {}
+
+	// Merge the state of the instance of a thread into the module loaded by
+	// the simulation. The instances of the threads are merged one at a time
+	// in no particular order.
+	// params: thread_module - Instance of a thread of the same module class.
+	virtual void merge(const Module& thread_module) {
+		(void)thread_module;
+	}
+
+	// Complete the run after the instances of all threads were merged, e.g.
+	// report the state accumulated over the events.
+	virtual void finalize() {}
+
 	// Main method for each module. This method is called in each event to
 	// execute the module given the information about the current event.
+	// The result of the module is appended to the output of the event which
+	// is reused between events, so modules appending to it don't allocate.
 	// params: event - Current event of the simulation.
-	// Note: This should be pure virtual.
-	virtual std::string run(const Event &, std::mt19937* random_engine);
+	//         output - Output of the current event.
+	// Note: By default adapts modules implementing the string version of run.
+	virtual void run(const Event &, RandomEngine* random_engine, OutputSink& output);
+
+	// Main method for each module returning its result as a string.
+	// params: event - Current event of the simulation.
+	// Note: This should be pure virtual. Kept for modules that return their
+	// result, new modules should implement the output sink version of run.
+	virtual std::string run(const Event &, RandomEngine* random_engine);
+
+	// Returns whether the module implements runBlock. When all modules of a
+	// simulation do, the simulation executes the events in blocks.
+	virtual bool supportsBlocks() const {
+		return false;
+	}
+
+	// Execute the module for a block of consecutive events. The stream of
+	// every event continues where the previous module left it, so drawing
+	// the numbers of all events at once with random_streams.draw gives the
+	// same numbers as executing the events one at a time.
+	// params: events - The events of the block.
+	//         random_streams - Random number streams of the events, event i
+	// 		of the block draws from lane i.
+	// Note: By default executes the events one at a time with run.
+	virtual void runBlock(const EventBlock& events, MultiStreamEngine& random_streams);
+
+	// Returns whether the results of the module for an event only depend on
+	// the event and the random numbers it draws, and the module keeps no
+	// state over the events. The results of such modules are kept in the
+	// result cache of a simulation and taken from it by the following runs
+	// instead of executing the module.
+	virtual bool supportsResultCache() const {
+		return false;
+	}
 
 protected:
 	// Constructor of the abstract class. It's made protected to enforce this
 	// class being abstract and only derived classes can be instantiated.
 	Module(std::string name) : name_(name) {}
 
+	// Draw two random numbers and append them with the module name to the
+	// output without allocating any memory. This is what all example modules
+	// do. Produces the same result as the string version of run. Templated
+	// on the engine so that the draws can be inlined for a concrete engine.
+	template <typename Engine>
+	void writeRandomNumbers(Engine& random_engine, OutputSink& output) const {
+		// draw two random numbers
+		uint32_t numbers[2];
+		numbers[0] = random_engine();
+		numbers[1] = random_engine();
+
+		output.appendValues(name_, numbers, 2);
+	}
+
+	// Draw two random numbers for every event of the block and append them
+	// with the module name to the outputs of the events. Same as calling
+	// writeRandomNumbers for every event of the block.
+	void writeRandomNumbers(const EventBlock& events, MultiStreamEngine& random_streams) const;
+
 	// module unique name
 	std::string name_;
 };
@@ -1,11 +1,42 @@
 #pragma once
 
 #include "module.hpp"
+#include "moduleRegistry.hpp"
+#include "event.hpp"
 
 // Example of a module
-class Module2 : public Module
+class Module2 final : public Module
 {
 public:
     Module2() : Module("Module2") {
     }
+
+    using Module::run;
+
+    // Draw two random numbers without allocating any memory.
+    void run(const Event& e, RandomEngine* random_engine, OutputSink& output) override {
+        process(e, *random_engine, output);
+    }
+
+    bool supportsBlocks() const override {
+        return true;
+    }
+
+    bool supportsResultCache() const override {
+        return true;
+    }
+
+    // Draw two random numbers for all events of the block at once.
+    void runBlock(const EventBlock& events, MultiStreamEngine& random_streams) override {
+        writeRandomNumbers(events, random_streams);
+    }
+
+    // Non virtual implementation of run, used directly by StaticPipeline so
+    // that the module can be inlined in the event loop.
+    template <typename Engine>
+    void process(const Event&, Engine& random_engine, OutputSink& output) {
+        writeRandomNumbers(random_engine, output);
+    }
 };
+
+REGISTER_MODULE(Module2);
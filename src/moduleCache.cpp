@@ -0,0 +1,23 @@
+#include "moduleCache.hpp"
+#include "module.hpp"
+
+// Take a cached instance of the named module for the given use.
+std::shared_ptr<Module> ModuleCache::acquire(const std::string& name, Use use)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::vector<std::shared_ptr<Module>>& modules = (use == Use::LOADED ? loaded_ : thread_)[name];
+    if (modules.empty()) {
+        return nullptr;
+    }
+
+    std::shared_ptr<Module> module = std::move(modules.back());
+    modules.pop_back();
+    return module;
+}
+
+// Keep an instance of the named module for the following simulations.
+void ModuleCache::release(const std::string& name, Use use, std::shared_ptr<Module> module)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    (use == Use::LOADED ? loaded_ : thread_)[name].push_back(std::move(module));
+}
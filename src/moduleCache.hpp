@@ -0,0 +1,42 @@
+#pragma once
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+class Module;
+
+// Instances of modules kept for the following simulations of a process, e.g.
+// the simulations of a sweep, so they don't create and initialize their
+// modules again. A simulation takes the instances it needs and returns them
+// when it no longer uses them, simulations running at the same time never
+// share an instance.
+class ModuleCache
+{
+public:
+    // Use of an instance of a module in a simulation.
+    enum class Use {
+        // module loaded by the simulation, initialized once created
+        LOADED,
+
+        // instance executing the events of a thread
+        THREAD
+    };
+
+    // Take a cached instance of the named module for the given use.
+    // returns: pointer to the instance or null if none is cached.
+    std::shared_ptr<Module> acquire(const std::string& name, Use use);
+
+    // Keep an instance of the named module for the following simulations.
+    void release(const std::string& name, Use use, std::shared_ptr<Module> module);
+
+private:
+    // cached instances of each use hashed by module name
+    std::unordered_map<std::string, std::vector<std::shared_ptr<Module>>> loaded_;
+    std::unordered_map<std::string, std::vector<std::shared_ptr<Module>>> thread_;
+
+    // protects the cached instances
+    std::mutex mutex_;
+};
@@ -0,0 +1,101 @@
+#include "modulePipeline.hpp"
+#include "cpuTopology.hpp"
+
+
+ModulePipeline::ModulePipeline(size_t number_of_stages, size_t number_of_slots,
+    StageFunction stage_function, const std::vector<std::vector<int>>& stage_cpus)
+    : stage_function_(std::move(stage_function)), slot_batches_(number_of_slots, 0)
+{
+    // every ring can hold all slots and the end marker, so handing a slot
+    // on never fails
+    for (size_t i = 0; i <= number_of_stages; ++i) {
+        rings_.emplace_back(new Ring(number_of_slots + 1));
+    }
+    for (size_t slot = 0; slot < number_of_slots; ++slot) {
+        put(*rings_.back(), slot);
+    }
+
+    for (size_t stage = 0; stage < number_of_stages; ++stage) {
+        stages_.push_back(std::thread(&ModulePipeline::runStage, this, stage,
+            stage < stage_cpus.size() ? stage_cpus[stage] : std::vector<int>()));
+    }
+}
+
+// Submit a batch to the first stage.
+void ModulePipeline::submit(size_t batch)
+{
+    size_t slot = take(*rings_.back());
+    slot_batches_[slot] = batch;
+    put(*rings_.front(), slot);
+}
+
+// Block waiting for all submitted batches to pass the last stage.
+void ModulePipeline::finish()
+{
+    // the end marker follows the last batch through all stages
+    put(*rings_.front(), END_OF_BATCHES);
+    for (std::thread& stage : stages_) {
+        stage.join();
+    }
+}
+
+// Main loop of the thread of the given stage.
+void ModulePipeline::runStage(size_t stage, const std::vector<int>& cpus)
+{
+    if (!cpus.empty()) {
+        CpuTopology::pinCurrentThread(cpus);
+    }
+
+    Ring& input = *rings_[stage];
+    Ring& output = *rings_[stage + 1];
+    bool last_stage = (stage + 2 == rings_.size());
+    while (true) {
+        size_t slot = take(input);
+        if (slot == END_OF_BATCHES) {
+            if (!last_stage) {
+                put(output, slot);
+            }
+            break;
+        }
+
+        stage_function_(stage, slot, slot_batches_[slot]);
+        put(output, slot);
+    }
+}
+
+// Take the next slot from the ring. Stages mostly wait for a slot only
+// briefly, so spin for a while before blocking.
+size_t ModulePipeline::take(Ring& ring)
+{
+    size_t slot;
+    for (int spin = 0; spin < SPIN_COUNT; ++spin) {
+        if (ring.queue.pop(slot)) {
+            return slot;
+        }
+        std::this_thread::yield();
+    }
+
+    // announce the wait before the last attempt, so a slot put after it
+    // finds the waiting thread and wakes it up
+    std::unique_lock<std::mutex> lock(ring.mutex);
+    ring.waiting.fetch_add(1);
+    ring.ready.wait(lock, [&ring, &slot]() {
+        return ring.queue.pop(slot);
+    });
+    ring.waiting.fetch_sub(1);
+    return slot;
+}
+
+// Put a slot into a ring that is large enough to hold all slots.
+void ModulePipeline::put(Ring& ring, size_t slot)
+{
+    ring.queue.push(std::move(slot));
+
+    // pairs with announcing the wait in take, either the waiting thread
+    // finds the slot or it is seen waiting here
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (ring.waiting.load() > 0) {
+        std::lock_guard<std::mutex> lock(ring.mutex);
+        ring.ready.notify_all();
+    }
+}
@@ -0,0 +1,89 @@
+#pragma once
+
+#include "boundedQueue.hpp"
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Executes batches of events as a pipeline of stages, each stage running a
+// group of consecutive modules on its own thread. Batches flow from one
+// stage to the next through lock free rings in submission order, so each
+// module only ever runs on the thread of its stage and its state stays in
+// the cache of that thread's core.
+//
+// A fixed pool of slots circulates through the stages: the producer takes a
+// free slot for every submitted batch, the slot is handed from stage to
+// stage and returns to the free ring after the last stage. The data of the
+// batches, e.g. their random number engines and results, is kept by the
+// client per slot so the pipeline itself doesn't allocate while running.
+class ModulePipeline
+{
+public:
+    // Function executing a stage of the pipeline for the batch in a slot.
+    // params: stage - Index of the stage.
+    //         slot - Index of the slot holding the batch.
+    //         batch - The batch of events.
+    using StageFunction = std::function<void(size_t stage, size_t slot, size_t batch)>;
+
+    // Start a thread per stage. Stages with CPUs in stage_cpus are pinned
+    // to them.
+    ModulePipeline(size_t number_of_stages, size_t number_of_slots, StageFunction stage_function,
+        const std::vector<std::vector<int>>& stage_cpus = {});
+
+    // Copys are not allowed.
+    ModulePipeline(const ModulePipeline&) = delete;
+    ModulePipeline& operator=(const ModulePipeline&) = delete;
+
+    // Submit a batch to the first stage. Blocks the caller while all slots
+    // are in use.
+    void submit(size_t batch);
+
+    // Block waiting for all submitted batches to pass the last stage.
+    // Nothing can be submitted after this call.
+    void finish();
+
+private:
+    // slot index marking the end of the batches
+    static constexpr size_t END_OF_BATCHES = static_cast<size_t>(-1);
+
+    // number of attempts to take a slot from a ring before blocking
+    static constexpr int SPIN_COUNT = 64;
+
+    // Ring of slot indices passed from one stage to the next. Threads
+    // finding the ring empty spin briefly and then block until a slot is
+    // put, the lock is only taken while a thread is blocked.
+    struct Ring {
+        explicit Ring(size_t capacity) : queue(capacity) {}
+
+        BoundedQueue<size_t> queue;
+        std::atomic<size_t> waiting {0};
+        std::mutex mutex;
+        std::condition_variable ready;
+    };
+
+    // Main loop of the thread of the given stage.
+    void runStage(size_t stage, const std::vector<int>& cpus);
+
+    // Take the next slot from the ring, waiting until there is one.
+    static size_t take(Ring& ring);
+
+    // Put a slot into a ring that is large enough to hold all slots.
+    static void put(Ring& ring, size_t slot);
+
+    // function executing the stages
+    StageFunction stage_function_;
+
+    // batch held by each slot
+    std::vector<size_t> slot_batches_;
+
+    // rings feeding each stage, followed by the ring of free slots
+    std::vector<std::unique_ptr<Ring>> rings_;
+
+    // thread of each stage
+    std::vector<std::thread> stages_;
+};
@@ -0,0 +1,40 @@
+#include "moduleRegistry.hpp"
+
+#include <algorithm>
+
+// Returns the registry shared by the whole program. Constructed on first use
+// so that modules can register themselves during static initialization.
+ModuleRegistry& ModuleRegistry::instance()
+{
+    static ModuleRegistry registry;
+    return registry;
+}
+
+// Register a module factory under the given name.
+bool ModuleRegistry::add(const std::string& name, FactoryType factory)
+{
+    return factories_.emplace(name, factory).second;
+}
+
+// Create a module given its name.
+std::shared_ptr<Module> ModuleRegistry::create(const std::string& name) const
+{
+    auto it = factories_.find(name);
+    if (it == factories_.end()) {
+        return nullptr;
+    }
+
+    return it->second();
+}
+
+// Returns the names of all registered modules sorted alphabetically.
+std::vector<std::string> ModuleRegistry::getModuleNames() const
+{
+    std::vector<std::string> names;
+    for (auto& factory : factories_) {
+        names.push_back(factory.first);
+    }
+    std::sort(names.begin(), names.end());
+
+    return names;
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+class Module;
+
+// Registry of the modules available to the simulations. Modules register a
+// factory function under their name, typically with the REGISTER_MODULE
+// macro placed after their class definition, and are looked up by the hash
+// of their name when a simulation loads them.
+class ModuleRegistry
+{
+public:
+    using FactoryType = std::shared_ptr<Module> (*)();
+
+    // Returns the registry shared by the whole program.
+    static ModuleRegistry& instance();
+
+    // Register a module factory under the given name.
+    // returns: false if a module with this name is already registered.
+    bool add(const std::string& name, FactoryType factory);
+
+    // Create a module given its name.
+    // returns: pointer to the module or null if there is no such module.
+    std::shared_ptr<Module> create(const std::string& name) const;
+
+    // Returns the names of all registered modules.
+    std::vector<std::string> getModuleNames() const;
+
+private:
+    ModuleRegistry() = default;
+
+    // module factories hashed by module name
+    std::unordered_map<std::string, FactoryType> factories_;
+};
+
+// Register a module class with the registry under its class name. Placed at
+// namespace scope after the definition of the module.
+#define REGISTER_MODULE(ModuleClass) \
+    static const bool ModuleClass##_registered = ModuleRegistry::instance().add(#ModuleClass, \
+        []() -> std::shared_ptr<Module> { return std::make_shared<ModuleClass>(); }); \
+    static_assert(true, "")
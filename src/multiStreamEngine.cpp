@@ -0,0 +1,412 @@
+#include "multiStreamEngine.hpp"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define MULTI_STREAM_X86 1
+#include <immintrin.h>
+#endif
+
+namespace {
+
+constexpr size_t LANES = MultiStreamEngine::LANES;
+
+// parameters of std::mt19937
+constexpr size_t STATE_SIZE = 624;
+constexpr size_t SHIFT_SIZE = 397;
+constexpr uint32_t MATRIX = 0x9908b0dfu;
+constexpr uint32_t UPPER_MASK = 0x80000000u;
+constexpr uint32_t LOWER_MASK = 0x7fffffffu;
+constexpr uint32_t INIT_MULTIPLIER = 1812433253u;
+
+// Index of the word following the given word of the state, and of the word
+// the twist combines it with.
+inline size_t nextWord(size_t i) {
+    return i + 1 == STATE_SIZE ? 0 : i + 1;
+}
+
+inline size_t shiftedWord(size_t i) {
+    return i + SHIFT_SIZE < STATE_SIZE ? i + SHIFT_SIZE : i + SHIFT_SIZE - STATE_SIZE;
+}
+
+inline uint32_t temper(uint32_t y) {
+    y ^= y >> 11;
+    y ^= (y << 7) & 0x9d2c5680u;
+    y ^= (y << 15) & 0xefc60000u;
+    return y ^ (y >> 18);
+}
+
+// The states are stored word by word, word i of the stream in lane l at
+// state[i * LANES + l]. Each kernel advances all lanes.
+
+void seedScalar(uint32_t* state, const uint32_t* seeds) {
+    for (size_t lane = 0; lane < LANES; ++lane) {
+        state[lane] = seeds[lane];
+    }
+    for (size_t i = 1; i < STATE_SIZE; ++i) {
+        const uint32_t* previous = state + (i - 1) * LANES;
+        uint32_t* word = state + i * LANES;
+        for (size_t lane = 0; lane < LANES; ++lane) {
+            word[lane] = INIT_MULTIPLIER * (previous[lane] ^ (previous[lane] >> 30))
+                + static_cast<uint32_t>(i);
+        }
+    }
+}
+
+void twistScalar(uint32_t* state, size_t first_lane, size_t last_lane) {
+    for (size_t i = 0; i < STATE_SIZE; ++i) {
+        uint32_t* word = state + i * LANES;
+        const uint32_t* next = state + nextWord(i) * LANES;
+        const uint32_t* shifted = state + shiftedWord(i) * LANES;
+        for (size_t lane = first_lane; lane < last_lane; ++lane) {
+            uint32_t y = (word[lane] & UPPER_MASK) | (next[lane] & LOWER_MASK);
+            word[lane] = shifted[lane] ^ (y >> 1) ^ ((y & 1) ? MATRIX : 0);
+        }
+    }
+}
+
+void temperScalar(const uint32_t* word, uint32_t* values) {
+    for (size_t lane = 0; lane < LANES; ++lane) {
+        values[lane] = temper(word[lane]);
+    }
+}
+
+#ifdef MULTI_STREAM_X86
+
+// AVX2 kernels, the 16 lanes are held in two registers.
+
+__attribute__((target("avx2")))
+void seedAvx2(uint32_t* state, const uint32_t* seeds) {
+    const __m256i multiplier = _mm256_set1_epi32(static_cast<int>(INIT_MULTIPLIER));
+    __m256i low = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(seeds));
+    __m256i high = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(seeds + 8));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(state), low);
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(state + 8), high);
+    for (size_t i = 1; i < STATE_SIZE; ++i) {
+        const __m256i index = _mm256_set1_epi32(static_cast<int>(i));
+        low = _mm256_add_epi32(_mm256_mullo_epi32(
+            _mm256_xor_si256(low, _mm256_srli_epi32(low, 30)), multiplier), index);
+        high = _mm256_add_epi32(_mm256_mullo_epi32(
+            _mm256_xor_si256(high, _mm256_srli_epi32(high, 30)), multiplier), index);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(state + i * LANES), low);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(state + i * LANES + 8), high);
+    }
+}
+
+__attribute__((target("avx2")))
+void twistAvx2(uint32_t* state) {
+    const __m256i upper_mask = _mm256_set1_epi32(static_cast<int>(UPPER_MASK));
+    const __m256i lower_mask = _mm256_set1_epi32(static_cast<int>(LOWER_MASK));
+    const __m256i matrix = _mm256_set1_epi32(static_cast<int>(MATRIX));
+    const __m256i one = _mm256_set1_epi32(1);
+    for (size_t i = 0; i < STATE_SIZE; ++i) {
+        for (size_t half = 0; half < LANES; half += 8) {
+            __m256i* word = reinterpret_cast<__m256i*>(state + i * LANES + half);
+            const __m256i* next = reinterpret_cast<const __m256i*>(state + nextWord(i) * LANES + half);
+            const __m256i* shifted = reinterpret_cast<const __m256i*>(state + shiftedWord(i) * LANES + half);
+            __m256i y = _mm256_or_si256(_mm256_and_si256(_mm256_loadu_si256(word), upper_mask),
+                _mm256_and_si256(_mm256_loadu_si256(next), lower_mask));
+            __m256i odd = _mm256_cmpeq_epi32(_mm256_and_si256(y, one), one);
+            __m256i x = _mm256_xor_si256(_mm256_loadu_si256(shifted), _mm256_srli_epi32(y, 1));
+            _mm256_storeu_si256(word, _mm256_xor_si256(x, _mm256_and_si256(odd, matrix)));
+        }
+    }
+}
+
+__attribute__((target("avx2")))
+void temperAvx2(const uint32_t* word, uint32_t* values) {
+    const __m256i mask_b = _mm256_set1_epi32(static_cast<int>(0x9d2c5680u));
+    const __m256i mask_c = _mm256_set1_epi32(static_cast<int>(0xefc60000u));
+    for (size_t half = 0; half < LANES; half += 8) {
+        __m256i y = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(word + half));
+        y = _mm256_xor_si256(y, _mm256_srli_epi32(y, 11));
+        y = _mm256_xor_si256(y, _mm256_and_si256(_mm256_slli_epi32(y, 7), mask_b));
+        y = _mm256_xor_si256(y, _mm256_and_si256(_mm256_slli_epi32(y, 15), mask_c));
+        y = _mm256_xor_si256(y, _mm256_srli_epi32(y, 18));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(values + half), y);
+    }
+}
+
+// AVX-512 kernels, the 16 lanes are held in one register. The shift
+// intrinsics of some compilers start from an undefined register that is
+// reported as uninitialized.
+
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wuninitialized"
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+
+__attribute__((target("avx512f")))
+void seedAvx512(uint32_t* state, const uint32_t* seeds) {
+    const __m512i multiplier = _mm512_set1_epi32(static_cast<int>(INIT_MULTIPLIER));
+    __m512i x = _mm512_loadu_si512(seeds);
+    _mm512_storeu_si512(state, x);
+    for (size_t i = 1; i < STATE_SIZE; ++i) {
+        x = _mm512_add_epi32(_mm512_mullo_epi32(_mm512_xor_si512(x, _mm512_srli_epi32(x, 30)), multiplier),
+            _mm512_set1_epi32(static_cast<int>(i)));
+        _mm512_storeu_si512(state + i * LANES, x);
+    }
+}
+
+__attribute__((target("avx512f")))
+void twistAvx512(uint32_t* state) {
+    const __m512i upper_mask = _mm512_set1_epi32(static_cast<int>(UPPER_MASK));
+    const __m512i lower_mask = _mm512_set1_epi32(static_cast<int>(LOWER_MASK));
+    const __m512i matrix = _mm512_set1_epi32(static_cast<int>(MATRIX));
+    const __m512i one = _mm512_set1_epi32(1);
+    for (size_t i = 0; i < STATE_SIZE; ++i) {
+        uint32_t* word = state + i * LANES;
+        __m512i y = _mm512_or_si512(_mm512_and_si512(_mm512_loadu_si512(word), upper_mask),
+            _mm512_and_si512(_mm512_loadu_si512(state + nextWord(i) * LANES), lower_mask));
+        __mmask16 odd = _mm512_test_epi32_mask(y, one);
+        __m512i x = _mm512_xor_si512(_mm512_loadu_si512(state + shiftedWord(i) * LANES),
+            _mm512_srli_epi32(y, 1));
+        _mm512_storeu_si512(word, _mm512_mask_xor_epi32(x, odd, x, matrix));
+    }
+}
+
+__attribute__((target("avx512f")))
+void temperAvx512(const uint32_t* word, uint32_t* values) {
+    __m512i y = _mm512_loadu_si512(word);
+    y = _mm512_xor_si512(y, _mm512_srli_epi32(y, 11));
+    y = _mm512_xor_si512(y, _mm512_and_si512(_mm512_slli_epi32(y, 7),
+        _mm512_set1_epi32(static_cast<int>(0x9d2c5680u))));
+    y = _mm512_xor_si512(y, _mm512_and_si512(_mm512_slli_epi32(y, 15),
+        _mm512_set1_epi32(static_cast<int>(0xefc60000u))));
+    y = _mm512_xor_si512(y, _mm512_srli_epi32(y, 18));
+    _mm512_storeu_si512(values, y);
+}
+
+#pragma GCC diagnostic pop
+
+#endif
+
+// Streams of the mersenne twister advanced in lockstep. Drawing from the
+// stream of a single event makes the streams diverge, they are then
+// advanced one lane at a time until they are seeded again.
+class Mt19937Streams final : public MultiStreamEngine
+{
+public:
+    explicit Mt19937Streams(InstructionSet instruction_set) : instruction_set_(instruction_set) {
+        for (size_t lane = 0; lane < LANES; ++lane) {
+            streams_[lane].streams_ = this;
+            streams_[lane].lane_ = lane;
+        }
+        uint32_t seeds[LANES] = {};
+        seed(seeds, LANES);
+    }
+
+    const char* getName() const override {
+        return "mt19937";
+    }
+
+    void seed(const uint32_t* seeds, size_t count) override {
+        uint32_t lane_seeds[LANES] = {};
+        for (size_t lane = 0; lane < count && lane < LANES; ++lane) {
+            lane_seeds[lane] = seeds[lane];
+        }
+
+        switch (instruction_set_) {
+#ifdef MULTI_STREAM_X86
+        case InstructionSet::AVX512:
+            seedAvx512(state_, lane_seeds);
+            break;
+        case InstructionSet::AVX2:
+            seedAvx2(state_, lane_seeds);
+            break;
+#endif
+        default:
+            seedScalar(state_, lane_seeds);
+        }
+
+        for (size_t lane = 0; lane < LANES; ++lane) {
+            index_[lane] = STATE_SIZE;
+        }
+        lockstep_ = true;
+    }
+
+    void draw(uint32_t* values) override {
+        if (!lockstep_) {
+            for (size_t lane = 0; lane < LANES; ++lane) {
+                values[lane] = drawLane(lane);
+            }
+            return;
+        }
+
+        size_t index = index_[0];
+        if (index == STATE_SIZE) {
+            twist();
+            index = 0;
+        }
+
+        const uint32_t* word = state_ + index * LANES;
+        switch (instruction_set_) {
+#ifdef MULTI_STREAM_X86
+        case InstructionSet::AVX512:
+            temperAvx512(word, values);
+            break;
+        case InstructionSet::AVX2:
+            temperAvx2(word, values);
+            break;
+#endif
+        default:
+            temperScalar(word, values);
+        }
+
+        for (size_t lane = 0; lane < LANES; ++lane) {
+            index_[lane] = index + 1;
+        }
+    }
+
+    RandomEngine& getStream(size_t lane) override {
+        return streams_[lane];
+    }
+
+private:
+    // Stream of a single lane.
+    class LaneEngine final : public RandomEngine
+    {
+    public:
+        const char* getName() const override {
+            return "mt19937";
+        }
+
+        void seed(result_type value) override {
+            streams_->seedLane(lane_, value);
+        }
+
+        result_type operator()() override {
+            return streams_->drawLane(lane_);
+        }
+
+        Mt19937Streams* streams_ {nullptr};
+        size_t lane_ {0};
+    };
+
+    // Twist the states of all lanes.
+    void twist() {
+        switch (instruction_set_) {
+#ifdef MULTI_STREAM_X86
+        case InstructionSet::AVX512:
+            twistAvx512(state_);
+            break;
+        case InstructionSet::AVX2:
+            twistAvx2(state_);
+            break;
+#endif
+        default:
+            twistScalar(state_, 0, LANES);
+        }
+    }
+
+    // Restart the stream of a single lane.
+    void seedLane(size_t lane, uint32_t value) {
+        state_[lane] = value;
+        for (size_t i = 1; i < STATE_SIZE; ++i) {
+            uint32_t previous = state_[(i - 1) * LANES + lane];
+            state_[i * LANES + lane] = INIT_MULTIPLIER * (previous ^ (previous >> 30))
+                + static_cast<uint32_t>(i);
+        }
+        index_[lane] = STATE_SIZE;
+        lockstep_ = false;
+    }
+
+    // Draw the next number of a single lane.
+    uint32_t drawLane(size_t lane) {
+        lockstep_ = false;
+        if (index_[lane] == STATE_SIZE) {
+            twistScalar(state_, lane, lane + 1);
+            index_[lane] = 0;
+        }
+        return temper(state_[index_[lane]++ * LANES + lane]);
+    }
+
+    // instruction set the lanes are advanced with
+    InstructionSet instruction_set_;
+
+    // states of the streams, word by word
+    uint32_t state_[STATE_SIZE * LANES];
+
+    // index of the next word drawn by each stream
+    size_t index_[LANES];
+
+    // whether all streams draw from the same index
+    bool lockstep_ {true};
+
+    // engines drawing from a single stream
+    LaneEngine streams_[LANES];
+};
+
+// Streams of any other engine, an engine per stream.
+class EngineStreams final : public MultiStreamEngine
+{
+public:
+    explicit EngineStreams(const std::string& name) {
+        for (size_t lane = 0; lane < LANES; ++lane) {
+            engines_[lane] = RandomEngine::createRandomEngine(name);
+        }
+    }
+
+    const char* getName() const override {
+        return engines_[0]->getName();
+    }
+
+    void seed(const uint32_t* seeds, size_t count) override {
+        count_ = count < LANES ? count : LANES;
+        for (size_t lane = 0; lane < count_; ++lane) {
+            engines_[lane]->seed(seeds[lane]);
+        }
+    }
+
+    void draw(uint32_t* values) override {
+        for (size_t lane = 0; lane < count_; ++lane) {
+            values[lane] = (*engines_[lane])();
+        }
+    }
+
+    RandomEngine& getStream(size_t lane) override {
+        return *engines_[lane];
+    }
+
+private:
+    std::unique_ptr<RandomEngine> engines_[LANES];
+
+    // number of streams seeded
+    size_t count_ {0};
+};
+
+}
+
+// Factory method for creating the streams of an engine. The mersenne
+// twister is advanced in lockstep, other engines with an engine per stream.
+// params: name - The name of the engine.
+//         instruction_set - Instruction set to advance the streams with.
+// returns: pointer to the streams or null if there is no such engine.
+std::unique_ptr<MultiStreamEngine> MultiStreamEngine::createMultiStreamEngine(const std::string& name,
+    InstructionSet instruction_set)
+{
+    std::unique_ptr<MultiStreamEngine> ptr = nullptr;
+
+    if (instruction_set > getInstructionSet()) {
+        instruction_set = InstructionSet::SCALAR;
+    }
+
+    if (name == "mt19937") {
+        ptr.reset(new Mt19937Streams(instruction_set));
+    } else if (RandomEngine::createRandomEngine(name)) {
+        ptr.reset(new EngineStreams(name));
+    }
+
+    return ptr;
+}
+
+// Returns the widest instruction set supported by the machine.
+MultiStreamEngine::InstructionSet MultiStreamEngine::getInstructionSet()
+{
+#ifdef MULTI_STREAM_X86
+    if (__builtin_cpu_supports("avx512f")) {
+        return InstructionSet::AVX512;
+    }
+    if (__builtin_cpu_supports("avx2")) {
+        return InstructionSet::AVX2;
+    }
+#endif
+    return InstructionSet::SCALAR;
+}
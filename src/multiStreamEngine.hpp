@@ -0,0 +1,58 @@
+#pragma once
+
+#include "randomEngine.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+// Random number streams of a block of events, one stream per event. Every
+// stream draws exactly the numbers of the engine of the same name seeded
+// with the seed of its event, so modules draw the same numbers whether they
+// execute the events one at a time or in blocks.
+//
+// The mersenne twister keeps the states of all streams as a structure of
+// arrays, word by word, so seeding, twisting and tempering advance the
+// streams of 16 events at once in the lanes of AVX-512 or AVX2 registers.
+// The instruction set is chosen at run time, other machines fall back to
+// scalar loops over the lanes. Other engines draw from an engine per stream.
+class MultiStreamEngine
+{
+public:
+    // number of streams, i.e. the maximum number of events of a block
+    static constexpr size_t LANES = 16;
+
+    // Instruction sets the streams can be advanced with.
+    enum class InstructionSet { SCALAR, AVX2, AVX512 };
+
+    // Virtual destructor as all derived classes are handled with a base pointer.
+    virtual ~MultiStreamEngine() = default;
+
+    // Factory method for creating the streams of an engine.
+    // params: name - The name of the engine, same as for RandomEngine.
+    //         instruction_set - Instruction set to advance the streams
+    //         with, scalar if the machine doesn't support it.
+    // returns: pointer to the streams or null if there is no such engine.
+    static std::unique_ptr<MultiStreamEngine> createMultiStreamEngine(const std::string& name,
+        InstructionSet instruction_set = getInstructionSet());
+
+    // Returns the widest instruction set supported by the machine.
+    static InstructionSet getInstructionSet();
+
+    // Returns the name of the engine.
+    virtual const char* getName() const = 0;
+
+    // Restart the streams of the given number of events, at most LANES,
+    // from their seeds.
+    virtual void seed(const uint32_t* seeds, size_t count) = 0;
+
+    // Draw the next random number of every stream.
+    // params: values - Receives LANES numbers, the number of each stream at
+    //         its lane. Lanes of streams that weren't seeded are undefined.
+    virtual void draw(uint32_t* values) = 0;
+
+    // Returns the stream of an event as an engine drawing its next numbers,
+    // e.g. for modules executing the events of a block one at a time.
+    virtual RandomEngine& getStream(size_t lane) = 0;
+};
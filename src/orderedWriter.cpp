@@ -0,0 +1,212 @@
+#include "orderedWriter.hpp"
+#include "instrumentation.hpp"
+
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+
+OrderedWriter::OrderedWriter(std::ostream& output, size_t number_of_results, size_t window_size,
+    Instrumentation* instrumentation)
+    : output_(&output), number_of_results_(number_of_results),
+      window_(window_size > 0 ? window_size : 1), ready_(window_.size(), 0),
+      instrumentation_(instrumentation)
+{
+    writer_ = std::thread(&OrderedWriter::flush, this);
+}
+
+OrderedWriter::OrderedWriter(int fd, size_t number_of_results, size_t window_size,
+    Instrumentation* instrumentation)
+    : fd_(fd), number_of_results_(number_of_results),
+      window_(window_size > 0 ? window_size : 1), ready_(window_.size(), 0),
+      instrumentation_(instrumentation)
+{
+    writer_ = std::thread(&OrderedWriter::flush, this);
+}
+
+OrderedWriter::~OrderedWriter()
+{
+    close();
+}
+
+// Block until the given sequence number fits in the reorder window.
+void OrderedWriter::reserve(size_t sequence)
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    space_available_.wait(lock, [this, sequence]() {
+        return sequence < next_ + window_.size();
+    });
+}
+
+// Hand the result of the given sequence number to the writer.
+void OrderedWriter::write(size_t sequence, const char* result, size_t size)
+{
+    // the slot of a reserved sequence number is not used by anyone else
+    // until it is marked ready, so the copy can happen without the lock
+    size_t slot = sequence % window_.size();
+    window_[slot].assign(result, size);
+
+    bool is_next;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        ready_[slot] = 1;
+        is_next = (sequence == next_);
+    }
+
+    // only the result the writer is waiting for is worth a wake up
+    if (is_next) {
+        result_ready_.notify_one();
+    }
+}
+
+// Block until all results are written to the output stream.
+void OrderedWriter::close()
+{
+    if (writer_.joinable()) {
+        writer_.join();
+    }
+}
+
+// Set the function called by the writer thread after writing results.
+void OrderedWriter::setFlushCallback(FlushCallback callback)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    on_flush_ = std::move(callback);
+}
+
+// Main loop of the writer thread. Waits for the next result in order and
+// writes it together with all the consecutive results that are already
+// ready, then frees their slots in the window.
+void OrderedWriter::flush()
+{
+    // timing statistics of the writer, if recorded
+    Instrumentation::ThreadStatistics* statistics = nullptr;
+    if (instrumentation_) {
+        statistics = &instrumentation_->local("writer");
+    }
+
+    while (true) {
+        size_t first, last;
+        FlushCallback on_flush;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            if (next_ >= number_of_results_) {
+                break;
+            }
+
+            result_ready_.wait(lock, [this]() {
+                return ready_[next_ % window_.size()] != 0;
+            });
+
+            // collect the run of consecutive ready results
+            first = next_;
+            last = next_ + 1;
+            while (last < number_of_results_ && last < first + window_.size()
+                    && ready_[last % window_.size()]) {
+                ++last;
+            }
+            on_flush = on_flush_;
+        }
+
+        // slots of ready results are not touched by anyone else until they
+        // are freed, so they can be written without holding the lock
+        int64_t flush_start = statistics ? Instrumentation::now() : 0;
+        for (size_t i = first; i < last; ++i) {
+            bytes_written_ += window_[i % window_.size()].size();
+        }
+        if (output_) {
+            for (size_t i = first; i < last; ++i) {
+                *output_ << window_[i % window_.size()];
+            }
+            output_->flush();
+            failed_ = failed_ || output_->fail();
+        } else if (!failed_) {
+            failed_ = !writeResults(first, last);
+        }
+        if (statistics) {
+            int64_t flush_end = Instrumentation::now();
+            statistics->flush_time.record(static_cast<uint64_t>(flush_end - flush_start));
+            statistics->recordSpan("flush", first, flush_start, flush_end);
+        }
+
+        // free the written slots and wake up the producer
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            for (size_t i = first; i < last; ++i) {
+                size_t slot = i % window_.size();
+                window_[slot].clear();
+                ready_[slot] = 0;
+            }
+            next_ = last;
+        }
+        space_available_.notify_all();
+
+        if (on_flush && !failed_) {
+            on_flush(last, bytes_written_);
+        }
+    }
+}
+
+// Write the results in the given range of sequence numbers to the file
+// descriptor, as many of them per system call as it accepts.
+bool OrderedWriter::writeResults(size_t first, size_t last)
+{
+    struct iovec vectors[IOV_MAX];
+
+    size_t next = first;
+    while (next < last) {
+        size_t count = std::min<size_t>(last - next, IOV_MAX);
+        for (size_t i = 0; i < count; ++i) {
+            std::string& result = window_[(next + i) % window_.size()];
+            vectors[i].iov_base = &result[0];
+            vectors[i].iov_len = result.size();
+        }
+
+        // write the vectors, skipping what was written by partial writes
+        struct iovec* vector = vectors;
+        struct iovec* end = vectors + count;
+        while (vector < end) {
+            ssize_t written = writev(fd_, vector, static_cast<int>(end - vector));
+            if (written < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                return false;
+            }
+
+            size_t remaining = static_cast<size_t>(written);
+            while (vector < end && remaining >= vector->iov_len) {
+                remaining -= vector->iov_len;
+                ++vector;
+            }
+            if (vector < end) {
+                vector->iov_base = static_cast<char*>(vector->iov_base) + remaining;
+                vector->iov_len -= remaining;
+            }
+        }
+
+        next += count;
+    }
+
+    return true;
+}
+
+// Write all the given data to a file descriptor.
+bool OrderedWriter::writeFully(int fd, const char* data, size_t size)
+{
+    while (size > 0) {
+        ssize_t written = ::write(fd, data, size);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        data += written;
+        size -= static_cast<size_t>(written);
+    }
+
+    return true;
+}
@@ -0,0 +1,130 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <ostream>
+
+class Instrumentation;
+
+// Streaming output stage of the simulation. Results of the events are
+// produced out of order by the worker threads, this class reorders them
+// using a bounded window and flushes them to the output in order while the
+// workers keep going.
+//
+// The output is either a stream or a file descriptor. Results written to a
+// file descriptor go straight from the window slots to the kernel, a single
+// writev call covers all the consecutive results that are ready.
+//
+// Each result is identified by a sequence number starting from zero. The
+// producer must reserve a sequence number before handing the work out, this
+// blocks the producer while the window is full so that at most window size
+// results are held in memory at any point in time.
+class OrderedWriter
+{
+public:
+    // Function called by the writer thread after writing results, given the
+    // number of results and the number of bytes written so far.
+    using FlushCallback = std::function<void(size_t, uint64_t)>;
+    // Construct a writer that expects number_of_results results in total and
+    // holds at most window_size of them in memory. Starts the writer thread.
+    // The optional instrumentation records the time spent writing the output.
+    OrderedWriter(std::ostream& output, size_t number_of_results, size_t window_size,
+        Instrumentation* instrumentation = nullptr);
+
+    // Construct a writer writing to the given file descriptor, which is not
+    // closed by the writer.
+    OrderedWriter(int fd, size_t number_of_results, size_t window_size,
+        Instrumentation* instrumentation = nullptr);
+
+    // Waits for the writer thread to finish.
+    ~OrderedWriter();
+
+    // Copys are not allowed.
+    OrderedWriter(const OrderedWriter&) = delete;
+    OrderedWriter& operator=(const OrderedWriter&) = delete;
+
+    // Block until the given sequence number fits in the reorder window.
+    // Must be called by the producer before the work of this sequence
+    // number is submitted.
+    void reserve(size_t sequence);
+
+    // Hand the result of the given sequence number to the writer. The result
+    // is copied into the window slot which keeps its capacity between uses,
+    // so no memory is allocated once the slots have grown.
+    // Never blocks for long, it is safe to be called by the worker threads.
+    void write(size_t sequence, const char* result, size_t size);
+
+    // Block until all results are written to the output stream.
+    void close();
+
+    // Set the function called by the writer thread after writing results.
+    void setFlushCallback(FlushCallback callback);
+
+    // Returns whether writing to the file descriptor or stream failed.
+    // Results that could not be written are dropped. Must be called after
+    // close.
+    bool failed() const {
+        return failed_;
+    }
+
+    // Write all the given data to a file descriptor, retrying after partial
+    // writes and interruptions.
+    // returns: false if writing failed.
+    static bool writeFully(int fd, const char* data, size_t size);
+
+private:
+    // Main loop of the writer thread.
+    void flush();
+
+    // Write the results in the given range of sequence numbers to the file
+    // descriptor.
+    bool writeResults(size_t first, size_t last);
+
+    // output stream where results are written, null when writing to the
+    // file descriptor
+    std::ostream* output_ {nullptr};
+
+    // file descriptor where results are written, if there is no stream
+    int fd_ {-1};
+
+    // whether writing to the file descriptor failed
+    bool failed_ {false};
+
+    // total number of results to write
+    size_t number_of_results_ {0};
+
+    // sequence number of the next result to be written
+    size_t next_ {0};
+
+    // number of bytes written, only used by the writer thread
+    uint64_t bytes_written_ {0};
+
+    // function called after writing results, if any
+    FlushCallback on_flush_;
+
+    // results waiting to be written, indexed by sequence number modulo window size
+    std::vector<std::string> window_;
+
+    // whether the result in the corresponding window slot is ready
+    std::vector<char> ready_;
+
+    // mutex protecting the window and the sequence numbers
+    std::mutex mutex_;
+
+    // signaled when the next result to be written becomes ready
+    std::condition_variable result_ready_;
+
+    // signaled when results are written and slots in the window are freed
+    std::condition_variable space_available_;
+
+    // optional timing statistics of the writer, null if not recorded
+    Instrumentation* instrumentation_ {nullptr};
+
+    // thread writing the results to the output stream
+    std::thread writer_;
+};
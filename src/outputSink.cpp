@@ -0,0 +1,173 @@
+#include "outputSink.hpp"
+#include "binaryFormat.hpp"
+
+// definitions of the constants passed by reference to push_back
+constexpr uint16_t BinaryFormat::TEXT_RECORD;
+
+// Add a record of values to the current event of a binary sink, or add the
+// values to the aggregates of a summary sink. Values of modules missing from
+// the module names are kept as text, summaries leave them out.
+void OutputSink::appendRecord(const std::string& module, const uint32_t* values, size_t count)
+{
+    // modules append their records in the same order for every event, so
+    // the expected module is almost always the right one
+    const std::vector<std::string>& names = *module_names_;
+    size_t index = next_module_;
+    if (index >= names.size() || names[index] != module) {
+        index = 0;
+        while (index < names.size() && names[index] != module) {
+            ++index;
+        }
+    }
+
+    if (format_ == Format::SUMMARY) {
+        if (index < names.size()) {
+            summary_.addValues(index, values, count);
+            next_module_ = (index + 1) % names.size();
+        }
+        return;
+    }
+
+    if (index == names.size()) {
+        append(module);
+        for (size_t i = 0; i < count; ++i) {
+            append('_');
+            appendNumber(values[i]);
+        }
+        append('\n');
+        return;
+    }
+    next_module_ = (index + 1) % names.size();
+
+    modules_.push_back(static_cast<uint16_t>(index));
+    counts_.push_back(static_cast<uint32_t>(count));
+    values_.insert(values_.end(), values, values + count);
+    ++records_per_event_.back();
+}
+
+// Add text to the current event of a binary sink. Text following text of
+// the same event extends its record.
+void OutputSink::appendText(const char* data, size_t size)
+{
+    if (records_per_event_.back() == 0 || modules_.back() != BinaryFormat::TEXT_RECORD) {
+        modules_.push_back(BinaryFormat::TEXT_RECORD);
+        counts_.push_back(0);
+        ++records_per_event_.back();
+    }
+
+    counts_.back() += static_cast<uint32_t>(size);
+    text_.append(data, size);
+}
+
+// Append the columns of the events of another binary sink.
+void OutputSink::appendColumns(const OutputSink& other)
+{
+    if (records_per_event_.empty()) {
+        first_event_ = other.first_event_;
+    }
+
+    records_per_event_.insert(records_per_event_.end(), other.records_per_event_.begin(),
+        other.records_per_event_.end());
+    counts_.insert(counts_.end(), other.counts_.begin(), other.counts_.end());
+    values_.insert(values_.end(), other.values_.begin(), other.values_.end());
+    modules_.insert(modules_.end(), other.modules_.begin(), other.modules_.end());
+    text_.append(other.text_);
+}
+
+namespace {
+    // Append a column to the block, padded to the alignment of the format.
+    template <typename T>
+    void appendColumn(std::string& block, const T* data, size_t size)
+    {
+        block.append(reinterpret_cast<const char*>(data), size * sizeof(T));
+        block.append(BinaryFormat::align(block.size()) - block.size(), '\0');
+    }
+}
+
+// Encode the columns of a binary sink into a block.
+void OutputSink::encodeBlock()
+{
+    BinaryFormat::BlockHeader header {
+        BinaryFormat::BLOCK_MAGIC,
+        first_event_,
+        static_cast<uint32_t>(records_per_event_.size()),
+        static_cast<uint32_t>(modules_.size()),
+        static_cast<uint32_t>(values_.size()),
+        static_cast<uint32_t>(text_.size())
+    };
+
+    buffer_.clear();
+    appendColumn(buffer_, &header, 1);
+    appendColumn(buffer_, records_per_event_.data(), records_per_event_.size());
+    appendColumn(buffer_, counts_.data(), counts_.size());
+    appendColumn(buffer_, values_.data(), values_.size());
+    appendColumn(buffer_, modules_.data(), modules_.size());
+    appendColumn(buffer_, text_.data(), text_.size());
+}
+
+namespace {
+    // Append a 32 bit word to a recorded sink.
+    void appendWord(std::string& buffer, uint32_t word)
+    {
+        buffer.append(reinterpret_cast<const char*>(&word), sizeof(word));
+    }
+
+    // Pad a recorded sink to whole words.
+    void padToWord(std::string& buffer)
+    {
+        buffer.append((sizeof(uint32_t) - buffer.size() % sizeof(uint32_t)) % sizeof(uint32_t), '\0');
+    }
+}
+
+// Add a record of values to a recorded sink.
+void OutputSink::recordValues(const std::string& module, const uint32_t* values, size_t count)
+{
+    appendWord(buffer_, static_cast<uint32_t>(module.size()));
+    buffer_.append(module);
+    padToWord(buffer_);
+    appendWord(buffer_, static_cast<uint32_t>(count));
+    buffer_.append(reinterpret_cast<const char*>(values), count * sizeof(uint32_t));
+    text_item_ = NO_TEXT_ITEM;
+}
+
+// Add text to a recorded sink. Text following text extends its item.
+void OutputSink::recordText(const char* data, size_t size)
+{
+    uint32_t text_size = 0;
+    if (text_item_ == NO_TEXT_ITEM) {
+        text_item_ = buffer_.size();
+        appendWord(buffer_, TEXT_ITEM);
+        appendWord(buffer_, 0);
+    } else {
+        std::memcpy(&text_size, &buffer_[text_item_ + sizeof(uint32_t)], sizeof(text_size));
+        buffer_.resize(text_item_ + 2 * sizeof(uint32_t) + text_size);
+    }
+
+    text_size += static_cast<uint32_t>(size);
+    std::memcpy(&buffer_[text_item_ + sizeof(uint32_t)], &text_size, sizeof(text_size));
+    buffer_.append(data, size);
+    padToWord(buffer_);
+}
+
+// Append the values and text held by a recorded sink.
+void OutputSink::replay(const char* data, size_t size)
+{
+    // items are whole words, so the values are aligned as the data
+    const uint32_t* item = reinterpret_cast<const uint32_t*>(data);
+    const uint32_t* end = reinterpret_cast<const uint32_t*>(data + size);
+    std::string module;
+    while (item < end) {
+        uint32_t item_size = item[0];
+        const char* characters = reinterpret_cast<const char*>(item + (item_size == TEXT_ITEM ? 2 : 1));
+        if (item_size == TEXT_ITEM) {
+            append(characters, item[1]);
+            item += 2 + (item[1] + sizeof(uint32_t) - 1) / sizeof(uint32_t);
+        } else {
+            module.assign(characters, item_size);
+            item += 1 + (item_size + sizeof(uint32_t) - 1) / sizeof(uint32_t);
+            uint32_t count = item[0];
+            appendValues(module, item + 1, count);
+            item += 1 + count;
+        }
+    }
+}
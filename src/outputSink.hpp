@@ -0,0 +1,270 @@
+#pragma once
+
+#include "summary.hpp"
+
+#include <string>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+// Output buffer the modules append the results of an event to. The buffer
+// is reused from one event to the next and keeps its capacity when cleared,
+// so appending to it doesn't allocate any memory once it has grown to the
+// size of the largest result.
+//
+// The results are either kept as text or in the columns of a block of the
+// binary result format described in binaryFormat.hpp. Values appended with
+// appendValues are stored as numbers in the binary format, anything else is
+// stored as text, so both formats hold the same results. A summary sink
+// keeps no results at all, only the aggregates of the appended values in a
+// Summary, and drops any text. A recorded sink keeps the values and text in
+// the order they were appended, so they can be replayed into a sink of any
+// format, e.g. the results of a module kept in the ResultCache.
+class OutputSink
+{
+public:
+    // Format of the results held by the sink.
+    enum class Format { TEXT, BINARY, SUMMARY, RECORDED };
+
+    // Select the format of the results, which clears the sink. Binary and
+    // summary sinks refer to the modules by their index in the given names,
+    // the names must outlive the use of the sink.
+    void setFormat(Format format, const std::vector<std::string>* module_names = nullptr) {
+        format_ = format;
+        module_names_ = module_names;
+        next_module_ = 0;
+        clear();
+    }
+
+    // Returns the format of the results held by the sink.
+    Format getFormat() const {
+        return format_;
+    }
+
+    // Start the results of the event with the given number.
+    void beginEvent(unsigned int number) {
+        if (format_ == Format::TEXT) {
+            buffer_.append("event #", 7);
+            appendNumber(number);
+            buffer_.push_back('\n');
+        } else if (format_ == Format::BINARY) {
+            if (records_per_event_.empty()) {
+                first_event_ = number;
+            }
+            records_per_event_.push_back(0);
+        } else if (format_ == Format::SUMMARY) {
+            summary_.addEvent();
+        }
+    }
+
+    // End the results of the current event.
+    void endEvent() {
+        if (format_ == Format::TEXT) {
+            buffer_.push_back('\n');
+        }
+    }
+
+    // Append the values drawn by a module for the current event. Same as
+    // appending the module name and the values separated by '_' followed
+    // by a new line.
+    void appendValues(const std::string& module, const uint32_t* values, size_t count) {
+        if (format_ == Format::TEXT) {
+            buffer_.append(module);
+            for (size_t i = 0; i < count; ++i) {
+                buffer_.push_back('_');
+                appendNumber(values[i]);
+            }
+            buffer_.push_back('\n');
+        } else if (format_ == Format::RECORDED) {
+            recordValues(module, values, count);
+        } else {
+            appendRecord(module, values, count);
+        }
+    }
+
+    // Append a single character.
+    void append(char c) {
+        if (format_ == Format::TEXT) {
+            buffer_.push_back(c);
+        } else if (format_ == Format::BINARY) {
+            appendText(&c, 1);
+        } else if (format_ == Format::RECORDED) {
+            recordText(&c, 1);
+        }
+    }
+
+    // Append a sequence of characters.
+    void append(const char* data, size_t size) {
+        if (format_ == Format::TEXT) {
+            buffer_.append(data, size);
+        } else if (format_ == Format::BINARY) {
+            appendText(data, size);
+        } else if (format_ == Format::RECORDED) {
+            recordText(data, size);
+        }
+    }
+
+    // Append a string.
+    void append(const std::string& s) {
+        append(s.data(), s.size());
+    }
+
+    // Append the decimal representation of an unsigned number. Same as
+    // std::to_string but formats in place two digits at a time.
+    void appendNumber(uint64_t value) {
+        char digits[MAX_DIGITS];
+        char* end = digits + MAX_DIGITS;
+        char* begin = end;
+
+        while (value >= 100) {
+            size_t pair = static_cast<size_t>(value % 100) * 2;
+            value /= 100;
+            begin -= 2;
+            std::memcpy(begin, DIGIT_PAIRS + pair, 2);
+        }
+        if (value >= 10) {
+            begin -= 2;
+            std::memcpy(begin, DIGIT_PAIRS + value * 2, 2);
+        } else {
+            *--begin = static_cast<char>('0' + value);
+        }
+
+        append(begin, end - begin);
+    }
+
+    // Append the events of another sink with the same format and module
+    // names, e.g. the results of an event collected on their own.
+    void appendEvents(const OutputSink& other) {
+        if (format_ == Format::TEXT) {
+            buffer_.append(other.buffer_);
+        } else if (format_ == Format::BINARY) {
+            appendColumns(other);
+        } else if (format_ == Format::SUMMARY) {
+            summary_.merge(other.summary_);
+        } else {
+            buffer_.append(other.buffer_);
+            text_item_ = NO_TEXT_ITEM;
+        }
+    }
+
+    // Append the values and text held by a recorded sink, as returned by its
+    // data and size, in the order they were appended to it. The results are
+    // the same as appending them to this sink in the first place.
+    void replay(const char* data, size_t size);
+
+    // Complete the results so that data() returns them. Text is held as is,
+    // binary results are encoded into a block of the events appended since
+    // the sink was cleared.
+    void finish() {
+        if (format_ == Format::BINARY) {
+            encodeBlock();
+        }
+    }
+
+    // Returns the aggregates of the values appended to a summary sink.
+    const Summary& getSummary() const {
+        return summary_;
+    }
+
+    // Returns the content of the buffer.
+    const char* data() const {
+        return buffer_.data();
+    }
+
+    // Returns the number of characters in the buffer.
+    size_t size() const {
+        return buffer_.size();
+    }
+
+    // Returns whether nothing was appended to the buffer.
+    bool empty() const {
+        return buffer_.empty();
+    }
+
+    // Remove the content of the buffer keeping its capacity.
+    void clear() {
+        buffer_.clear();
+        records_per_event_.clear();
+        counts_.clear();
+        values_.clear();
+        modules_.clear();
+        text_.clear();
+        summary_.clear();
+        text_item_ = NO_TEXT_ITEM;
+    }
+
+private:
+    // Add a record of values to the current event of a binary sink, or its
+    // values to the aggregates of a summary sink.
+    void appendRecord(const std::string& module, const uint32_t* values, size_t count);
+
+    // Add text to the current event of a binary sink.
+    void appendText(const char* data, size_t size);
+
+    // Append the columns of the events of another binary sink.
+    void appendColumns(const OutputSink& other);
+
+    // Encode the columns of a binary sink into a block.
+    void encodeBlock();
+
+    // Add a record of values to a recorded sink.
+    void recordValues(const std::string& module, const uint32_t* values, size_t count);
+
+    // Add text to a recorded sink.
+    void recordText(const char* data, size_t size);
+
+    // A recorded sink holds a sequence of items, each a sequence of 32 bit
+    // words. A record is the size of the module name, the name padded to
+    // whole words, the number of values and the values. Text is TEXT_ITEM,
+    // the number of characters and the characters padded to whole words.
+    static constexpr uint32_t TEXT_ITEM = 0xffffffff;
+
+    // offset of a recorded sink without a text item to extend
+    static constexpr size_t NO_TEXT_ITEM = static_cast<size_t>(-1);
+
+    // maximum number of decimal digits of a 64 bit number
+    static constexpr size_t MAX_DIGITS = 20;
+
+    // decimal representation of all numbers from 00 to 99
+    static constexpr const char* DIGIT_PAIRS =
+        "00010203040506070809"
+        "10111213141516171819"
+        "20212223242526272829"
+        "30313233343536373839"
+        "40414243444546474849"
+        "50515253545556575859"
+        "60616263646566676869"
+        "70717273747576777879"
+        "80818283848586878889"
+        "90919293949596979899";
+
+    // characters appended so far, or the encoded block of a binary sink
+    std::string buffer_;
+
+    // format of the results
+    Format format_ {Format::TEXT};
+
+    // names of the modules records refer to, binary sinks only
+    const std::vector<std::string>* module_names_ {nullptr};
+
+    // index of the module expected to append the next record, as modules
+    // append their records in the same order for every event
+    size_t next_module_ {0};
+
+    // number of the first event of the block
+    unsigned int first_event_ {0};
+
+    // columns of the block, see binaryFormat.hpp
+    std::vector<uint32_t> records_per_event_;
+    std::vector<uint32_t> counts_;
+    std::vector<uint32_t> values_;
+    std::vector<uint16_t> modules_;
+    std::string text_;
+
+    // aggregates of the values, summary sinks only
+    Summary summary_;
+
+    // offset of the last item of a recorded sink if it's text, which the
+    // following text extends
+    size_t text_item_ {NO_TEXT_ITEM};
+};
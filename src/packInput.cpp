@@ -0,0 +1,54 @@
+#include "inputFile.hpp"
+
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Packs the lines of a text file into an indexed input file, one record per
+// line without its new line, see inputFile.hpp.
+//
+// Usage: framework_pack lines.txt input.bin
+int main(int argc, char* argv[])
+{
+    if (argc != 3) {
+        std::cerr << "ERROR: Incorrect arguments\n";
+        std::cerr << "Usage: framework_pack lines.txt input.bin\n";
+        return -1;
+    }
+
+    std::ifstream lines(argv[1]);
+    if (!lines) {
+        std::cerr << "ERROR: Couldn't open " << argv[1] << '\n';
+        return -1;
+    }
+
+    // the offsets of the records precede the records, so the lines are
+    // read twice
+    std::vector<uint64_t> offsets {0};
+    std::string line;
+    while (std::getline(lines, line)) {
+        offsets.push_back(offsets.back() + line.size());
+    }
+
+    std::ofstream output(argv[2], std::ios::binary | std::ios::trunc);
+    InputFile::Header header {InputFile::MAGIC, InputFile::VERSION, offsets.size() - 1};
+    output.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    output.write(reinterpret_cast<const char*>(offsets.data()), offsets.size() * sizeof(uint64_t));
+
+    lines.clear();
+    lines.seekg(0);
+    while (std::getline(lines, line)) {
+        output.write(line.data(), line.size());
+    }
+
+    output.flush();
+    if (!output) {
+        std::cerr << "ERROR: Couldn't write " << argv[2] << '\n';
+        std::remove(argv[2]);
+        return -1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,22 @@
+#include "partitionedPool.hpp"
+
+PartitionedPool::PartitionedPool(std::vector<std::unique_ptr<Executor>>&& partitions)
+    : partitions_(std::move(partitions))
+{
+}
+
+// Submits a task to the next partition in round robin order.
+void PartitionedPool::submit(TaskType&& task)
+{
+    Executor& partition = *partitions_[next_partition_];
+    next_partition_ = (next_partition_ + 1) % partitions_.size();
+    partition.submit(std::move(task));
+}
+
+// Block waiting for the execution of all submitted events.
+void PartitionedPool::execute()
+{
+    for (std::unique_ptr<Executor>& partition : partitions_) {
+        partition->execute();
+    }
+}
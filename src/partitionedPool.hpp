@@ -0,0 +1,37 @@
+#pragma once
+
+#include "executor.hpp"
+
+#include <memory>
+#include <vector>
+
+// Executor made of one executor per partition of the workers, e.g. one
+// ThreadPool per NUMA node with its workers pinned to the CPUs of the node.
+// Tasks are distributed round robin over the partitions, so the workers of
+// a partition only share the queue of their partition and its cache lines
+// don't bounce between the nodes.
+class PartitionedPool : public Executor
+{
+public:
+    // Construct the pool from the executors of the partitions.
+    explicit PartitionedPool(std::vector<std::unique_ptr<Executor>>&& partitions);
+
+    // Copys are not allowed.
+    PartitionedPool(const PartitionedPool&) = delete;
+    PartitionedPool& operator=(const PartitionedPool&) = delete;
+
+    // Submits a task to the next partition in round robin order. Blocks the
+    // caller while the queue of that partition is full.
+    void submit(TaskType&& task) override;
+
+    // Block waiting for the execution of all submitted events.
+    // Any tasks submitted after this call will not be executed.
+    void execute() override;
+
+private:
+    // executors of the partitions
+    std::vector<std::unique_ptr<Executor>> partitions_;
+
+    // partition of the next submitted task
+    size_t next_partition_ {0};
+};
@@ -0,0 +1,22 @@
+#include "randomEngine.hpp"
+
+// Factory method for creating random number engines. Each new engine should
+// declare it self here
+// params: name - The name of the engine to create.
+// returns: pointer to the engine or null if there is no such engine.
+std::unique_ptr<RandomEngine> RandomEngine::createRandomEngine(const std::string& name)
+{
+    std::unique_ptr<RandomEngine> ptr = nullptr;
+
+    if (name == "mt19937") {
+        ptr.reset(new Mt19937Engine());
+    } else if (name == "splitmix64") {
+        ptr.reset(new SplitMix64Engine());
+    } else if (name == "xoshiro128") {
+        ptr.reset(new Xoshiro128Engine());
+    } else if (name == "philox4x32") {
+        ptr.reset(new PhiloxEngine());
+    }
+
+    return ptr;
+}
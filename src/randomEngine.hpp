@@ -0,0 +1,240 @@
+#pragma once
+
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <random>
+#include <string>
+
+// Random number engine used to draw the random numbers of an event. The
+// engine is reseeded with the seed of every event it executes, so the cost
+// of seeding matters as much as the cost of drawing a number.
+//
+// Satisfies the requirements of a uniform random bit generator, so it can
+// be used with the distributions of the standard library.
+class RandomEngine
+{
+public:
+    using result_type = uint32_t;
+
+    // Virtual destructor as all derived classes are handled with a base pointer.
+    virtual ~RandomEngine() = default;
+
+    // Factory method for creating random number engines.
+    // params: name - The name of the engine to create.
+    // returns: pointer to the engine or null if there is no such engine.
+    static std::unique_ptr<RandomEngine> createRandomEngine(const std::string& name);
+
+    // Returns the name of the engine.
+    virtual const char* getName() const = 0;
+
+    // Restart the stream of random numbers from the given seed.
+    virtual void seed(result_type value) = 0;
+
+    // Draw the next random number.
+    virtual result_type operator()() = 0;
+
+    // Smallest number the engine can draw.
+    static constexpr result_type min() {
+        return std::numeric_limits<result_type>::min();
+    }
+
+    // Largest number the engine can draw.
+    static constexpr result_type max() {
+        return std::numeric_limits<result_type>::max();
+    }
+};
+
+// Mersenne twister engine. This is the default engine of the framework.
+// Seeding initializes a state of 624 words.
+class Mt19937Engine final : public RandomEngine
+{
+public:
+    const char* getName() const override {
+        return "mt19937";
+    }
+
+    void seed(result_type value) override {
+        engine_.seed(value);
+    }
+
+    result_type operator()() override {
+        return static_cast<result_type>(engine_());
+    }
+
+private:
+    std::mt19937 engine_;
+};
+
+// SplitMix64 engine. A 64 bit counter scrambled by a mixing function, the
+// upper 32 bits of every output are used. Seeding is O(1).
+// See: http://prng.di.unimi.it/splitmix64.c
+class SplitMix64Engine final : public RandomEngine
+{
+public:
+    const char* getName() const override {
+        return "splitmix64";
+    }
+
+    void seed(result_type value) override {
+        state_ = value;
+    }
+
+    result_type operator()() override {
+        return static_cast<result_type>(next(state_) >> 32);
+    }
+
+    // Advance the given state and return its scrambled value.
+    static uint64_t next(uint64_t& state) {
+        uint64_t z = (state += 0x9e3779b97f4a7c15ULL);
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+        return z ^ (z >> 31);
+    }
+
+private:
+    uint64_t state_ {0};
+};
+
+// Xoshiro128** engine. Small state of 4 words initialized from the seed
+// using SplitMix64, which makes seeding O(1).
+// See: http://prng.di.unimi.it/xoshiro128starstar.c
+class Xoshiro128Engine final : public RandomEngine
+{
+public:
+    const char* getName() const override {
+        return "xoshiro128";
+    }
+
+    void seed(result_type value) override {
+        uint64_t state = value;
+        uint64_t word = SplitMix64Engine::next(state);
+        state_[0] = static_cast<uint32_t>(word);
+        state_[1] = static_cast<uint32_t>(word >> 32);
+        word = SplitMix64Engine::next(state);
+        state_[2] = static_cast<uint32_t>(word);
+        state_[3] = static_cast<uint32_t>(word >> 32);
+    }
+
+    result_type operator()() override {
+        const uint32_t result = rotate(state_[1] * 5, 7) * 9;
+        const uint32_t t = state_[1] << 9;
+
+        state_[2] ^= state_[0];
+        state_[3] ^= state_[1];
+        state_[1] ^= state_[2];
+        state_[0] ^= state_[3];
+        state_[2] ^= t;
+        state_[3] = rotate(state_[3], 11);
+
+        return result;
+    }
+
+private:
+    static uint32_t rotate(uint32_t x, int k) {
+        return (x << k) | (x >> (32 - k));
+    }
+
+    uint32_t state_[4] {0, 0, 0, 0};
+};
+
+// Philox4x32-10 counter based engine. Every block of 4 numbers is a keyed
+// bijection of a counter, so the key is the seed and seeding is O(1).
+// See: Salmon et al. "Parallel random numbers: as easy as 1, 2, 3", SC'11.
+class PhiloxEngine final : public RandomEngine
+{
+public:
+    const char* getName() const override {
+        return "philox4x32";
+    }
+
+    void seed(result_type value) override {
+        key_[0] = value;
+        key_[1] = 0;
+        counter_ = 0;
+        index_ = BLOCK_SIZE;
+    }
+
+    result_type operator()() override {
+        if (index_ == BLOCK_SIZE) {
+            generateBlock();
+            index_ = 0;
+        }
+        return block_[index_++];
+    }
+
+private:
+    // number of words generated from one counter value
+    static constexpr int BLOCK_SIZE = 4;
+
+    // Generate the block of the current counter and advance the counter.
+    void generateBlock() {
+        uint32_t x[4] = {
+            static_cast<uint32_t>(counter_), static_cast<uint32_t>(counter_ >> 32), 0, 0
+        };
+        uint32_t key[2] = {key_[0], key_[1]};
+
+        for (int round = 0; round < 10; ++round) {
+            uint64_t product0 = static_cast<uint64_t>(0xD2511F53u) * x[0];
+            uint64_t product1 = static_cast<uint64_t>(0xCD9E8D57u) * x[2];
+            uint32_t y[4] = {
+                static_cast<uint32_t>(product1 >> 32) ^ x[1] ^ key[0],
+                static_cast<uint32_t>(product1),
+                static_cast<uint32_t>(product0 >> 32) ^ x[3] ^ key[1],
+                static_cast<uint32_t>(product0)
+            };
+            x[0] = y[0]; x[1] = y[1]; x[2] = y[2]; x[3] = y[3];
+            key[0] += 0x9E3779B9u;
+            key[1] += 0xBB67AE85u;
+        }
+
+        block_[0] = x[0]; block_[1] = x[1]; block_[2] = x[2]; block_[3] = x[3];
+        ++counter_;
+    }
+
+    uint32_t key_[2] {0, 0};
+    uint64_t counter_ {0};
+    uint32_t block_[BLOCK_SIZE] {0, 0, 0, 0};
+    int index_ {BLOCK_SIZE};
+};
+
+// Engine drawing the numbers of another engine and counting them. The
+// position of an event in its stream is the count since the engine was
+// seeded, which is restored by seeding again and skipping as many numbers.
+class CountingEngine final : public RandomEngine
+{
+public:
+    explicit CountingEngine(RandomEngine& engine) : engine_(engine) {
+    }
+
+    const char* getName() const override {
+        return engine_.getName();
+    }
+
+    void seed(result_type value) override {
+        engine_.seed(value);
+        count_ = 0;
+    }
+
+    result_type operator()() override {
+        ++count_;
+        return engine_();
+    }
+
+    // Skip the given number of numbers.
+    void skip(uint64_t count) {
+        for (uint64_t i = 0; i < count; ++i) {
+            engine_();
+        }
+        count_ += count;
+    }
+
+    // Returns the number of numbers drawn since the engine was seeded.
+    uint64_t getCount() const {
+        return count_;
+    }
+
+private:
+    RandomEngine& engine_;
+    uint64_t count_ {0};
+};
@@ -0,0 +1,237 @@
+#include "resultCache.hpp"
+#include "orderedWriter.hpp"
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <iostream>
+#include <tuple>
+
+// definitions of the constants passed by reference
+constexpr uint32_t ResultCache::MAGIC;
+constexpr uint32_t ResultCache::VERSION;
+
+namespace {
+    // alignment of the sections of an entry
+    constexpr size_t ALIGNMENT = 8;
+
+    // Returns whether the name is the one of a file of the cache.
+    bool isEntry(const char* name, const char* suffix)
+    {
+        size_t size = std::strlen(name);
+        size_t suffix_size = std::strlen(suffix);
+        return size > suffix_size && std::strcmp(name + size - suffix_size, suffix) == 0;
+    }
+
+    // Append the bytes of an array to the file content.
+    template <typename T>
+    void appendArray(std::string& data, const T* values, size_t size)
+    {
+        data.append(reinterpret_cast<const char*>(values), size * sizeof(T));
+    }
+
+    // Copy an array out of the file content and advance the position.
+    template <typename T>
+    void readArray(const std::string& data, size_t& position, std::vector<T>& values, size_t size)
+    {
+        values.resize(size);
+        std::memcpy(values.data(), data.data() + position, size * sizeof(T));
+        position += size * sizeof(T);
+    }
+}
+
+// Open the directory of a result cache and add up the size of its files.
+std::unique_ptr<ResultCache> ResultCache::createResultCache(const std::string& directory, uint64_t max_size)
+{
+    if (mkdir(directory.c_str(), 0755) != 0 && errno != EEXIST) {
+        std::cerr << "ERROR: Couldn't create result cache " << directory << '\n';
+        return nullptr;
+    }
+
+    DIR* files = opendir(directory.c_str());
+    if (!files) {
+        std::cerr << "ERROR: Couldn't open result cache " << directory << '\n';
+        return nullptr;
+    }
+    closedir(files);
+
+    std::unique_ptr<ResultCache> cache(new ResultCache());
+    cache->directory_ = directory;
+    cache->max_size_ = max_size;
+    cache->size_ = cache->collectFiles(nullptr);
+
+    // the limit may be lower than the one of the runs filling the cache
+    if (cache->size_ > max_size) {
+        cache->evict();
+    }
+
+    return cache;
+}
+
+// Read the entry with the given key. A file of another key with the same
+// hash, or any file that is not a complete entry, is not the entry.
+bool ResultCache::read(const std::string& key, Entry& entry)
+{
+    int fd = open(getPath(key).c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+
+    // the whole file is read at once
+    static thread_local std::string data;
+    struct stat status;
+    bool valid = fstat(fd, &status) == 0 && static_cast<size_t>(status.st_size) >= sizeof(Header);
+    if (valid) {
+        data.resize(static_cast<size_t>(status.st_size));
+        valid = pread(fd, &data[0], data.size(), 0) == status.st_size;
+    }
+
+    Header header;
+    size_t key_end = 0;
+    if (valid) {
+        std::memcpy(&header, data.data(), sizeof(header));
+        key_end = sizeof(header) + (header.key_size + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+        valid = header.magic == MAGIC && header.version == VERSION && header.key_size == key.size()
+            && data.size() == key_end + (2 * header.number_of_events + 1) * sizeof(uint64_t) + header.results_size
+            && data.compare(sizeof(header), key.size(), key) == 0;
+    }
+
+    if (valid) {
+        size_t position = key_end;
+        readArray(data, position, entry.draws, header.number_of_events);
+        readArray(data, position, entry.offsets, header.number_of_events + 1);
+        entry.results.assign(data, position, header.results_size);
+        valid = entry.offsets.front() == 0 && entry.offsets.back() == header.results_size
+            && std::is_sorted(entry.offsets.begin(), entry.offsets.end());
+
+        // the entry was used now, the least recently used entries are
+        // removed first
+        futimens(fd, nullptr);
+    }
+    close(fd);
+
+    return valid;
+}
+
+// Write the entry under a temporary name and rename it, so it replaces an
+// older entry with the same key at once.
+void ResultCache::write(const std::string& key, const Entry& entry)
+{
+    Header header {
+        MAGIC,
+        VERSION,
+        static_cast<uint32_t>(key.size()),
+        static_cast<uint32_t>(entry.size()),
+        static_cast<uint64_t>(entry.results.size())
+    };
+
+    std::string data;
+    appendArray(data, &header, 1);
+    data.append(key);
+    data.append((ALIGNMENT - data.size() % ALIGNMENT) % ALIGNMENT, '\0');
+    appendArray(data, entry.draws.data(), entry.draws.size());
+    appendArray(data, entry.offsets.data(), entry.offsets.size());
+    data.append(entry.results);
+
+    std::string path = getPath(key);
+    std::string temporary;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        temporary = path + TEMPORARY_SUFFIX + std::to_string(getpid()) + '.' + std::to_string(temporary_files_++);
+    }
+
+    int fd = open(temporary.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        return;
+    }
+    bool written = OrderedWriter::writeFully(fd, data.data(), data.size());
+    close(fd);
+
+    struct stat replaced;
+    uint64_t replaced_size = (stat(path.c_str(), &replaced) == 0) ? static_cast<uint64_t>(replaced.st_size) : 0;
+    if (!written || rename(temporary.c_str(), path.c_str()) != 0) {
+        unlink(temporary.c_str());
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    size_ += data.size();
+    size_ -= std::min(size_, replaced_size);
+    if (size_ > max_size_) {
+        evict();
+    }
+}
+
+// Returns the path of the entry, named by the FNV-1a hash of its key.
+std::string ResultCache::getPath(const std::string& key) const
+{
+    uint64_t hash = 0xcbf29ce484222325;
+    for (char character : key) {
+        hash = (hash ^ static_cast<unsigned char>(character)) * 0x100000001b3;
+    }
+
+    char name[17];
+    std::snprintf(name, sizeof(name), "%016llx", static_cast<unsigned long long>(hash));
+    return directory_ + '/' + name + SUFFIX;
+}
+
+// Remove the least recently used files until the cache is down to three
+// quarters of its size limit, so the following writes don't evict again
+// right away. The size is taken from the directory, which other processes
+// sharing the cache may have changed.
+void ResultCache::evict()
+{
+    // time of last use, size and name of every entry
+    std::vector<std::tuple<int64_t, uint64_t, std::string>> entries;
+    size_ = collectFiles(&entries);
+
+    std::sort(entries.begin(), entries.end());
+    for (size_t i = 0; i < entries.size() && size_ > max_size_ / 4 * 3; ++i) {
+        if (unlink((directory_ + '/' + std::get<2>(entries[i])).c_str()) == 0) {
+            size_ -= std::get<1>(entries[i]);
+        }
+    }
+}
+
+// Add up the size of the files of the cache. Temporary files older than
+// STALE_TEMPORARY_SECONDS were left behind by a process that didn't finish
+// writing them and are removed, younger ones are being written and count
+// towards the size but aren't entries yet.
+uint64_t ResultCache::collectFiles(std::vector<std::tuple<int64_t, uint64_t, std::string>>* entries) const
+{
+    DIR* files = opendir(directory_.c_str());
+    if (!files) {
+        return 0;
+    }
+
+    std::string temporary_suffix = std::string(SUFFIX) + TEMPORARY_SUFFIX;
+    int64_t stale_time = static_cast<int64_t>(std::time(nullptr)) - STALE_TEMPORARY_SECONDS;
+    uint64_t size = 0;
+    while (dirent* file = readdir(files)) {
+        bool temporary = std::strstr(file->d_name, temporary_suffix.c_str()) != nullptr;
+        struct stat status;
+        if ((!temporary && !isEntry(file->d_name, SUFFIX)) || fstatat(dirfd(files), file->d_name, &status, 0) != 0) {
+            continue;
+        }
+
+        if (temporary && static_cast<int64_t>(status.st_mtim.tv_sec) < stale_time) {
+            unlinkat(dirfd(files), file->d_name, 0);
+            continue;
+        }
+        size += static_cast<uint64_t>(status.st_size);
+        if (!temporary && entries) {
+            int64_t used = static_cast<int64_t>(status.st_mtim.tv_sec) * 1000000000 + status.st_mtim.tv_nsec;
+            entries->emplace_back(used, static_cast<uint64_t>(status.st_size), file->d_name);
+        }
+    }
+    closedir(files);
+
+    return size;
+}
@@ -0,0 +1,140 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <tuple>
+#include <vector>
+
+// Results of modules kept on disk for the following runs. The results of a
+// module for an event are fully determined by the event, its seed and the
+// modules before it, so a run whose list of modules starts like the one of an
+// earlier run takes the results of those modules from the cache and only
+// executes the modules after them.
+//
+// Every entry holds the results of one module for a batch of events and is
+// stored in a file of its own, named by a hash of its key. The key names the
+// random number engine, the seeding, the events and all modules up to the
+// module of the entry. Files hold:
+//   header    - Header
+//   key       - the characters of the key padded to 8 bytes, compared with
+//               the key looked up so colliding hashes are told apart
+//   draws     - uint64_t position of the stream of every event after the
+//               module, i.e. the number of random numbers drawn by the event
+//               up to and including the module
+//   offsets   - uint64_t offset of the results of every event followed by
+//               the end of the results of the last event
+//   results   - the results of all events recorded by a sink of the
+//               RECORDED format, see outputSink.hpp
+// Numbers are stored in the byte order of the machine writing the file,
+// which is checked by the magic number.
+//
+// The files of the cache are kept below a size limit by removing the ones
+// least recently used. Files are written under a temporary name and renamed,
+// so runs sharing the cache, e.g. in separate processes, never read a partly
+// written entry. Temporary files of processes that died while writing them
+// are removed once they are old.
+class ResultCache
+{
+public:
+    // "FWRC" identifies an entry of the result cache
+    static constexpr uint32_t MAGIC = 0x43525746;
+
+    // version of the layout
+    static constexpr uint32_t VERSION = 1;
+
+    struct Header {
+        uint32_t magic;
+        uint32_t version;
+        uint32_t key_size;
+        uint32_t number_of_events;
+        uint64_t results_size;
+    };
+
+    // Results of one module for the events of a batch.
+    struct Entry {
+        std::vector<uint64_t> draws;
+        std::vector<uint64_t> offsets {0};
+        std::string results;
+
+        // Returns the number of events of the entry.
+        size_t size() const {
+            return draws.size();
+        }
+
+        // Add the results of the next event, recorded by a sink of the
+        // RECORDED format, and the position of its stream after the module.
+        void addEvent(uint64_t position, const char* data, size_t size) {
+            draws.push_back(position);
+            results.append(data, size);
+            offsets.push_back(results.size());
+        }
+
+        // Remove all events.
+        void clear() {
+            draws.clear();
+            offsets.assign(1, 0);
+            results.clear();
+        }
+    };
+
+    // Factory method for opening result caches.
+    // params: directory - The directory holding the files of the cache,
+    //              created if missing.
+    //         max_size - Limit on the size in bytes of all files of the cache.
+    // returns: pointer to the cache or null if the directory can't be used.
+    static std::unique_ptr<ResultCache> createResultCache(const std::string& directory, uint64_t max_size);
+
+    // Read the entry with the given key.
+    // returns: false if the cache has no such entry.
+    bool read(const std::string& key, Entry& entry);
+
+    // Write the entry with the given key, replacing any entry with the same
+    // key, and remove the least recently used entries if the cache grew
+    // beyond its size limit.
+    void write(const std::string& key, const Entry& entry);
+
+private:
+    ResultCache() = default;
+
+    // Returns the path of the file of the entry with the given key.
+    std::string getPath(const std::string& key) const;
+
+    // Remove the least recently used files until the cache is well below
+    // its size limit. Called with the mutex locked.
+    void evict();
+
+    // Add up the size of the files of the cache and remove the temporary
+    // files left behind.
+    // params: entries - Optional time of last use, size and name of every
+    //              entry.
+    // returns: the size of the files in bytes.
+    uint64_t collectFiles(std::vector<std::tuple<int64_t, uint64_t, std::string>>* entries) const;
+
+    // suffix of the files of the cache
+    static constexpr const char* SUFFIX = ".fwc";
+
+    // suffix of files being written, followed by the process and a number
+    static constexpr const char* TEMPORARY_SUFFIX = ".tmp";
+
+    // age in seconds of temporary files left behind by a process that
+    // didn't finish writing them
+    static constexpr int64_t STALE_TEMPORARY_SECONDS = 600;
+
+    // directory of the files of the cache
+    std::string directory_;
+
+    // limit on the size of the cache in bytes
+    uint64_t max_size_ {0};
+
+    // size of the files of the cache, as far as this process knows
+    uint64_t size_ {0};
+
+    // number of temporary files written by this process
+    uint64_t temporary_files_ {0};
+
+    // protects the size of the cache and the eviction
+    std::mutex mutex_;
+};
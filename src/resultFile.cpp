@@ -0,0 +1,217 @@
+#include "resultFile.hpp"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+// Factory method for opening result files.
+std::unique_ptr<ResultFile> ResultFile::createResultFile(const std::string& path)
+{
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        std::cerr << "ERROR: Couldn't open result file " << path << '\n';
+        return nullptr;
+    }
+
+    struct stat status;
+    std::unique_ptr<ResultFile> file(new ResultFile());
+    if (fstat(fd, &status) == 0 && status.st_size > 0) {
+        void* data = mmap(nullptr, static_cast<size_t>(status.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+        if (data != MAP_FAILED) {
+            file->data_ = static_cast<const char*>(data);
+            file->size_ = static_cast<size_t>(status.st_size);
+        }
+    }
+    close(fd);
+
+    if (!file->data_ || !file->parse()) {
+        std::cerr << "ERROR: Invalid result file " << path << '\n';
+        return nullptr;
+    }
+
+    return file;
+}
+
+ResultFile::~ResultFile()
+{
+    if (data_) {
+        munmap(const_cast<char*>(data_), size_);
+    }
+}
+
+// Parse the header, index and footer of the mapped file.
+bool ResultFile::parse()
+{
+    BinaryFormat::FileHeader header;
+    BinaryFormat::Footer footer;
+    if (size_ < sizeof(header) + sizeof(footer)) {
+        return false;
+    }
+
+    std::memcpy(&header, data_, sizeof(header));
+    std::memcpy(&footer, data_ + size_ - sizeof(footer), sizeof(footer));
+    if (header.magic != BinaryFormat::FILE_MAGIC || header.version != BinaryFormat::VERSION
+            || footer.magic != BinaryFormat::FOOTER_MAGIC || footer.version != BinaryFormat::VERSION) {
+        return false;
+    }
+
+    // names of the modules
+    size_t offset = sizeof(header);
+    for (uint32_t i = 0; i < header.number_of_modules; ++i) {
+        uint32_t length;
+        if (offset + sizeof(length) > size_) {
+            return false;
+        }
+        std::memcpy(&length, data_ + offset, sizeof(length));
+        offset += sizeof(length);
+        if (offset + length > size_) {
+            return false;
+        }
+        module_names_.emplace_back(data_ + offset, length);
+        offset += length;
+    }
+
+    // the index is right before the footer
+    size_t index_size = footer.number_of_blocks * sizeof(BinaryFormat::IndexEntry);
+    if (footer.index_offset % BinaryFormat::ALIGNMENT != 0
+            || footer.index_offset + index_size + sizeof(footer) != size_) {
+        return false;
+    }
+    index_ = reinterpret_cast<const BinaryFormat::IndexEntry*>(data_ + footer.index_offset);
+    number_of_blocks_ = footer.number_of_blocks;
+
+    return true;
+}
+
+// Returns the number of the first event in the file.
+unsigned int ResultFile::getFirstEvent() const
+{
+    return number_of_blocks_ > 0 ? index_[0].first_event : 1;
+}
+
+// Returns the number of the last event in the file.
+unsigned int ResultFile::getLastEvent() const
+{
+    if (number_of_blocks_ == 0) {
+        return 0;
+    }
+
+    const BinaryFormat::IndexEntry& last = index_[number_of_blocks_ - 1];
+    return last.first_event + last.number_of_events - 1;
+}
+
+// Returns the index entry of the block holding the given event, or null.
+const BinaryFormat::IndexEntry* ResultFile::findBlock(unsigned int event) const
+{
+    // first block starting after the event, the one before may hold it
+    const BinaryFormat::IndexEntry* end = index_ + number_of_blocks_;
+    const BinaryFormat::IndexEntry* block = std::upper_bound(index_, end, event,
+        [](unsigned int number, const BinaryFormat::IndexEntry& entry) {
+            return number < entry.first_event;
+        });
+
+    if (block == index_) {
+        return nullptr;
+    }
+    --block;
+
+    if (event - block->first_event >= block->number_of_events) {
+        return nullptr;
+    }
+    return block;
+}
+
+// Locate the encoded header and columns of the given block.
+bool ResultFile::getBlock(size_t block, const char*& data, size_t& size) const
+{
+    const BinaryFormat::IndexEntry& entry = index_[block];
+    BinaryFormat::BlockHeader header;
+    if (entry.offset + sizeof(header) > size_) {
+        return false;
+    }
+    std::memcpy(&header, data_ + entry.offset, sizeof(header));
+    if (header.magic != BinaryFormat::BLOCK_MAGIC || header.first_event != entry.first_event
+            || header.number_of_events != entry.number_of_events) {
+        return false;
+    }
+
+    data = data_ + entry.offset;
+    size = BinaryFormat::getBlockSize(header);
+    return entry.offset + size <= size_;
+}
+
+// Append the results of the events in the given range to the output.
+bool ResultFile::readEvents(unsigned int first, unsigned int last, OutputSink& output) const
+{
+    unsigned int event = first;
+    while (event <= last) {
+        const BinaryFormat::IndexEntry* entry = findBlock(event);
+        if (!entry) {
+            return false;
+        }
+
+        // locate the columns of the block
+        BinaryFormat::BlockHeader header;
+        if (entry->offset + sizeof(header) > size_) {
+            return false;
+        }
+        std::memcpy(&header, data_ + entry->offset, sizeof(header));
+        if (header.magic != BinaryFormat::BLOCK_MAGIC || header.first_event != entry->first_event
+                || header.number_of_events != entry->number_of_events) {
+            return false;
+        }
+
+        size_t offset = entry->offset + BinaryFormat::align(sizeof(header));
+        const uint32_t* records_per_event = reinterpret_cast<const uint32_t*>(data_ + offset);
+        offset += BinaryFormat::align(header.number_of_events * sizeof(uint32_t));
+        const uint32_t* counts = reinterpret_cast<const uint32_t*>(data_ + offset);
+        offset += BinaryFormat::align(header.number_of_records * sizeof(uint32_t));
+        const uint32_t* values = reinterpret_cast<const uint32_t*>(data_ + offset);
+        offset += BinaryFormat::align(header.number_of_values * sizeof(uint32_t));
+        const uint16_t* modules = reinterpret_cast<const uint16_t*>(data_ + offset);
+        offset += BinaryFormat::align(header.number_of_records * sizeof(uint16_t));
+        const char* text = data_ + offset;
+        if (offset + header.text_size > size_) {
+            return false;
+        }
+
+        // skip the records of the events before the first one to read
+        size_t record = 0;
+        size_t value = 0;
+        size_t character = 0;
+        size_t i = 0;
+        for (; i < event - header.first_event; ++i) {
+            for (size_t end = record + records_per_event[i]; record < end; ++record) {
+                if (modules[record] == BinaryFormat::TEXT_RECORD) {
+                    character += counts[record];
+                } else {
+                    value += counts[record];
+                }
+            }
+        }
+
+        // format the records of the events to read
+        for (; i < header.number_of_events && event <= last; ++i, ++event) {
+            output.beginEvent(event);
+            for (size_t end = record + records_per_event[i]; record < end; ++record) {
+                if (modules[record] == BinaryFormat::TEXT_RECORD) {
+                    output.append(text + character, counts[record]);
+                    character += counts[record];
+                } else if (modules[record] < module_names_.size()) {
+                    output.appendValues(module_names_[modules[record]], values + value, counts[record]);
+                    value += counts[record];
+                } else {
+                    return false;
+                }
+            }
+            output.endEvent();
+        }
+    }
+
+    return true;
+}
@@ -0,0 +1,83 @@
+#pragma once
+
+#include "binaryFormat.hpp"
+#include "outputSink.hpp"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+// Read only view of a binary result file, see binaryFormat.hpp. The file is
+// memory mapped and the events are located through the index of the file,
+// so reading any range of events only touches the blocks holding them.
+class ResultFile
+{
+public:
+    // Factory method for opening result files.
+    // params: path - The path of the binary result file.
+    // returns: pointer to the file or null if it can't be read or is not a
+    //          valid result file.
+    static std::unique_ptr<ResultFile> createResultFile(const std::string& path);
+
+    // Unmaps the file.
+    ~ResultFile();
+
+    // Copys are not allowed.
+    ResultFile(const ResultFile&) = delete;
+    ResultFile& operator=(const ResultFile&) = delete;
+
+    // Returns the names of the modules the records refer to.
+    const std::vector<std::string>& getModuleNames() const {
+        return module_names_;
+    }
+
+    // Returns the number of the first event in the file.
+    unsigned int getFirstEvent() const;
+
+    // Returns the number of the last event in the file, smaller than the
+    // first one if the file holds no events.
+    unsigned int getLastEvent() const;
+
+    // Returns the number of blocks in the file.
+    size_t getNumberOfBlocks() const {
+        return number_of_blocks_;
+    }
+
+    // Returns the index entry of the given block.
+    const BinaryFormat::IndexEntry& getIndexEntry(size_t block) const {
+        return index_[block];
+    }
+
+    // Locate the encoded header and columns of the given block.
+    // returns: false if the block is not within the file.
+    bool getBlock(size_t block, const char*& data, size_t& size) const;
+
+    // Append the results of the events in the given range to the output,
+    // which formats them as the simulation does.
+    // returns: false if an event of the range is not in the file.
+    bool readEvents(unsigned int first, unsigned int last, OutputSink& output) const;
+
+private:
+    ResultFile() = default;
+
+    // Parse the header, index and footer of the mapped file.
+    bool parse();
+
+    // Returns the index entry of the block holding the given event, or null.
+    const BinaryFormat::IndexEntry* findBlock(unsigned int event) const;
+
+    // start of the mapped file
+    const char* data_ {nullptr};
+
+    // size of the mapped file
+    size_t size_ {0};
+
+    // names of the modules the records refer to
+    std::vector<std::string> module_names_;
+
+    // index entries of the blocks in event order
+    const BinaryFormat::IndexEntry* index_ {nullptr};
+
+    // number of blocks in the file
+    size_t number_of_blocks_ {0};
+};
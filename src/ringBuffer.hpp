@@ -0,0 +1,91 @@
+#pragma once
+
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+// Growable circular buffer usable as the underlying container of std::queue.
+// Unlike std::deque it keeps its storage when elements are removed, so a
+// queue that is filled and drained repeatedly stops allocating memory once
+// it has grown to its largest size. Not thread safe.
+template <typename T>
+class RingBuffer
+{
+public:
+    using value_type = T;
+    using size_type = size_t;
+    using reference = T&;
+    using const_reference = const T&;
+
+    bool empty() const {
+        return size_ == 0;
+    }
+
+    size_type size() const {
+        return size_;
+    }
+
+    reference front() {
+        return buffer_[head_];
+    }
+
+    const_reference front() const {
+        return buffer_[head_];
+    }
+
+    reference back() {
+        return buffer_[(head_ + size_ - 1) % buffer_.size()];
+    }
+
+    const_reference back() const {
+        return buffer_[(head_ + size_ - 1) % buffer_.size()];
+    }
+
+    void push_back(T&& value) {
+        if (size_ == buffer_.size()) {
+            grow();
+        }
+        buffer_[(head_ + size_) % buffer_.size()] = std::move(value);
+        ++size_;
+    }
+
+    void push_back(const T& value) {
+        T copy(value);
+        push_back(std::move(copy));
+    }
+
+    template <typename... Args>
+    void emplace_back(Args&&... args) {
+        push_back(T(std::forward<Args>(args)...));
+    }
+
+    void pop_front() {
+        // release what the element holds but keep the slot
+        buffer_[head_] = T();
+        head_ = (head_ + 1) % buffer_.size();
+        --size_;
+    }
+
+private:
+    // initial number of slots
+    static constexpr size_t INITIAL_CAPACITY = 16;
+
+    // Double the number of slots moving the elements to the front.
+    void grow() {
+        std::vector<T> buffer(buffer_.empty() ? INITIAL_CAPACITY : buffer_.size() * 2);
+        for (size_t i = 0; i < size_; ++i) {
+            buffer[i] = std::move(buffer_[(head_ + i) % buffer_.size()]);
+        }
+        buffer_.swap(buffer);
+        head_ = 0;
+    }
+
+    // slots of the buffer
+    std::vector<T> buffer_;
+
+    // index of the first element
+    size_t head_ {0};
+
+    // number of elements
+    size_t size_ {0};
+};
@@ -0,0 +1,436 @@
+#include "server.hpp"
+#include "configuration.hpp"
+#include "cpuTopology.hpp"
+#include "executor.hpp"
+#include "instrumentation.hpp"
+#include "orderedWriter.hpp"
+#include "sharedExecutor.hpp"
+#include "simulation.hpp"
+
+#include <poll.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <climits>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <thread>
+
+namespace {
+
+// set by the signal handler once the server should stop
+volatile sig_atomic_t stop_requested = 0;
+
+void requestStop(int)
+{
+    stop_requested = 1;
+}
+
+// Fill the address of the socket at the given path.
+// returns: false if the path doesn't fit into the address.
+bool getAddress(const std::string& path, sockaddr_un& address)
+{
+    std::memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (path.empty() || path.size() >= sizeof(address.sun_path)) {
+        return false;
+    }
+    std::memcpy(address.sun_path, path.c_str(), path.size());
+    return true;
+}
+
+// Connect to the socket at the given path.
+// returns: descriptor of the connection or -1.
+int connectTo(const std::string& path)
+{
+    sockaddr_un address;
+    if (!getAddress(path, address)) {
+        return -1;
+    }
+
+    int connection = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (connection >= 0 && connect(connection, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0) {
+        close(connection);
+        connection = -1;
+    }
+    return connection;
+}
+
+// Time a client is given to send its request and the interval in which a
+// request being read checks whether the server stops.
+struct RequestDeadline {
+    std::chrono::steady_clock::time_point end;
+    const std::atomic<bool>* stopping;
+};
+
+constexpr int STOP_POLL_INTERVAL_MS = 100;
+
+// Wait until the connection can be read, the deadline passes or the server
+// stops.
+// returns: false if the connection can't be read in time.
+bool waitForData(int connection, const RequestDeadline& deadline)
+{
+    while (!*deadline.stopping) {
+        auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(
+            deadline.end - std::chrono::steady_clock::now()).count();
+        if (remaining <= 0) {
+            return false;
+        }
+
+        pollfd request {connection, POLLIN, 0};
+        int ready = poll(&request, 1, static_cast<int>(std::min<decltype(remaining)>(remaining, STOP_POLL_INTERVAL_MS)));
+        if (ready > 0) {
+            return true;
+        }
+        if (ready < 0 && errno != EINTR) {
+            return false;
+        }
+    }
+    return false;
+}
+
+// Read a line of at most the given size from the connection, optionally
+// giving up once the deadline passes.
+// returns: false if the connection was closed before the end of the line.
+bool readLine(int connection, std::string& line, size_t max_size, const RequestDeadline* deadline = nullptr)
+{
+    line.clear();
+    char character;
+    while (line.size() < max_size) {
+        if (deadline && !waitForData(connection, *deadline)) {
+            return false;
+        }
+        ssize_t count = read(connection, &character, 1);
+        if (count < 0 && errno == EINTR) {
+            continue;
+        }
+        if (count <= 0) {
+            return false;
+        }
+        if (character == '\n') {
+            return true;
+        }
+        line += character;
+    }
+    return false;
+}
+
+// Returns the path relative to the current working directory as an absolute
+// path, the server has a working directory of its own.
+std::string getAbsolutePath(const std::string& path)
+{
+    if (path.empty() || path[0] == '/') {
+        return path;
+    }
+
+    char directory[PATH_MAX];
+    if (!getcwd(directory, sizeof(directory))) {
+        return path;
+    }
+    return std::string(directory) + '/' + path;
+}
+
+} // namespace
+
+// Create the socket of the server.
+std::unique_ptr<Server> Server::createServer(const std::string& socket_path)
+{
+    sockaddr_un address;
+    if (!getAddress(socket_path, address)) {
+        std::cerr << "ERROR: Invalid socket path " << socket_path << '\n';
+        return nullptr;
+    }
+
+    std::unique_ptr<Server> server(new Server());
+    server->socket_ = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (server->socket_ < 0) {
+        std::cerr << "ERROR: Couldn't create socket " << socket_path << '\n';
+        return nullptr;
+    }
+
+    // only the user running the server may connect, jobs use its files
+    mode_t mask = umask(0177);
+    int bound = bind(server->socket_, reinterpret_cast<sockaddr*>(&address), sizeof(address));
+    if (bound != 0 && errno == EADDRINUSE) {
+        // a socket left behind by a server that is no longer running
+        // refuses connections and is replaced
+        int connection = connectTo(socket_path);
+        if (connection >= 0) {
+            close(connection);
+            umask(mask);
+            std::cerr << "ERROR: Another server is listening on " << socket_path << '\n';
+            return nullptr;
+        }
+        unlink(socket_path.c_str());
+        bound = bind(server->socket_, reinterpret_cast<sockaddr*>(&address), sizeof(address));
+    }
+    umask(mask);
+    if (bound != 0 || listen(server->socket_, SOMAXCONN) != 0) {
+        std::cerr << "ERROR: Couldn't listen on socket " << socket_path << '\n';
+        return nullptr;
+    }
+    server->socket_path_ = socket_path;
+
+    return server;
+}
+
+// Close and remove the socket.
+Server::~Server()
+{
+    if (socket_ >= 0) {
+        close(socket_);
+    }
+    if (!socket_path_.empty()) {
+        unlink(socket_path_.c_str());
+    }
+}
+
+// Accept and run jobs until the process is asked to stop. The signals
+// stopping the server are only delivered while waiting for connections, so
+// they can't get lost between checking for them and waiting.
+bool Server::run()
+{
+    sigset_t stop_signals, waiting_mask;
+    sigemptyset(&stop_signals);
+    sigaddset(&stop_signals, SIGINT);
+    sigaddset(&stop_signals, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &stop_signals, &waiting_mask);
+    sigdelset(&waiting_mask, SIGINT);
+    sigdelset(&waiting_mask, SIGTERM);
+
+    struct sigaction action;
+    std::memset(&action, 0, sizeof(action));
+    action.sa_handler = requestStop;
+    sigaction(SIGINT, &action, nullptr);
+    sigaction(SIGTERM, &action, nullptr);
+
+    // clients going away while their results are written must not stop the
+    // server
+    signal(SIGPIPE, SIG_IGN);
+
+    // the workers are created once for all jobs and adapt their number to
+    // the events submitted
+    size_t number_of_workers = CpuTopology::getAvailableCpus();
+    SharedExecutor executor(Executor::createExecutor("shared_queue", number_of_workers,
+        number_of_workers * PENDING_TASKS_PER_WORKER));
+    executor.setActiveWorkers(number_of_workers, true);
+
+    std::cout << "INFO: Listening on " << socket_path_ << std::endl;
+
+    bool succeeded = true;
+    while (!stop_requested) {
+        // connections beyond the limit of jobs wait in the backlog of the
+        // socket until a job is done
+        bool accepting;
+        {
+            std::lock_guard<std::mutex> lock(jobs_mutex_);
+            accepting = running_jobs_ < MAX_RUNNING_JOBS;
+        }
+        timespec interval {0, STOP_POLL_INTERVAL_MS * 1000000L};
+        pollfd request {socket_, POLLIN, 0};
+        int ready = ppoll(&request, accepting ? 1 : 0, accepting ? nullptr : &interval, &waiting_mask);
+        if (ready == 0) {
+            continue;
+        }
+        if (ready < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            std::cerr << "ERROR: Couldn't wait for connections on " << socket_path_ << '\n';
+            succeeded = false;
+            break;
+        }
+
+        int connection = accept4(socket_, nullptr, nullptr, SOCK_CLOEXEC);
+        if (connection < 0) {
+            continue;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(jobs_mutex_);
+            ++running_jobs_;
+        }
+        std::thread([this, connection, &executor]() {
+            runJob(connection, executor);
+
+            std::lock_guard<std::mutex> lock(jobs_mutex_);
+            --running_jobs_;
+            jobs_done_.notify_all();
+        }).detach();
+    }
+
+    // clients that haven't sent their request yet are turned away
+    stopping_ = true;
+    {
+        std::unique_lock<std::mutex> lock(jobs_mutex_);
+        jobs_done_.wait(lock, [this]() { return running_jobs_ == 0; });
+    }
+    executor.execute();
+
+    return succeeded;
+}
+
+// Read the request of a client, run its simulation on the shared executor
+// and close the connection.
+void Server::runJob(int connection, Executor& executor)
+{
+    std::string config_path, output_path, line;
+    std::string error;
+    size_t request_size = 0;
+    RequestDeadline deadline {std::chrono::steady_clock::now() + std::chrono::milliseconds(REQUEST_TIMEOUT_MS),
+        &stopping_};
+    bool complete = false;
+    while (readLine(connection, line, MAX_REQUEST_SIZE - request_size, &deadline)) {
+        if (line.empty()) {
+            complete = true;
+            break;
+        }
+        request_size += line.size() + 1;
+
+        std::stringstream tokenizer(line);
+        std::string key, equal_sign, value;
+        tokenizer >> key >> equal_sign >> value;
+        if (equal_sign != "=" || value.empty()) {
+            error = "Unexpected token " + equal_sign;
+        } else if (key == "config") {
+            config_path = value;
+        } else if (key == "output_file") {
+            output_path = value;
+        }
+    }
+
+    // a request not sent in time or while the server stops isn't run, the
+    // client gets no answer
+    if (!complete && (stopping_ || std::chrono::steady_clock::now() >= deadline.end)) {
+        close(connection);
+        return;
+    }
+
+    if (error.empty() && config_path.empty()) {
+        error = "Job without configuration";
+    }
+    Configuration config = Configuration::createConfiguration(config_path);
+    if (error.empty() && !config.correct()) {
+        error = "Incorrect configuration file " + config_path;
+    }
+
+    std::unique_ptr<Simulation> simulation;
+    if (error.empty()) {
+        if (!output_path.empty()) {
+            config.setOutputFile(output_path);
+        }
+
+        simulation.reset(new Simulation(config));
+        simulation->setExecutor(&executor);
+        simulation->setModuleCache(&module_cache_);
+        if (!simulation->init()) {
+            error = "Couldn't initialize simulation " + config_path;
+        }
+    }
+
+    std::string reply = error.empty() ? "OK\n" : "ERROR: " + error + '\n';
+    if (!OrderedWriter::writeFully(connection, reply.data(), reply.size()) || !error.empty()) {
+        close(connection);
+        return;
+    }
+
+    // optionally record timing statistics of the simulation
+    Instrumentation instrumentation(!config.getTraceFile().empty());
+    if (config.useInstrumentation()) {
+        simulation->setInstrumentation(&instrumentation);
+    }
+
+    // the status tells the client whether the results are complete
+    const char* trailer = simulation->run(connection) ? DONE_TRAILER : FAILED_TRAILER;
+    OrderedWriter::writeFully(connection, trailer, TRAILER_SIZE);
+    close(connection);
+
+    if (config.useInstrumentation()) {
+        std::lock_guard<std::mutex> lock(report_mutex_);
+        std::cout << "INFO: Statistics of " << config_path << '\n';
+        instrumentation.report(std::cout, config.getModuleNames());
+    }
+    if (!config.getTraceFile().empty()) {
+        std::ofstream trace_file(config.getTraceFile());
+        instrumentation.writeTrace(trace_file);
+        if (!trace_file) {
+            std::cerr << "ERROR: Couldn't write trace file " << config.getTraceFile() << '\n';
+        }
+    }
+}
+
+// Submit a job and copy the results streamed back to standard out.
+bool Server::submit(const std::string& socket_path, const std::string& config_path,
+    const std::string& output_path)
+{
+    int connection = connectTo(socket_path);
+    if (connection < 0) {
+        std::cerr << "ERROR: Couldn't connect to server " << socket_path << '\n';
+        return false;
+    }
+
+    std::string request = "config = " + getAbsolutePath(config_path) + '\n';
+    if (!output_path.empty()) {
+        request += "output_file = " + getAbsolutePath(output_path) + '\n';
+    }
+    request += '\n';
+
+    std::string reply;
+    if (!OrderedWriter::writeFully(connection, request.data(), request.size())
+            || !readLine(connection, reply, MAX_REQUEST_SIZE)) {
+        std::cerr << "ERROR: Server " << socket_path << " closed the connection\n";
+        close(connection);
+        return false;
+    }
+    if (reply != "OK") {
+        std::cerr << reply << '\n';
+        close(connection);
+        return false;
+    }
+
+    // the results bypass standard out, so the messages buffered in it go
+    // out first. The last characters received may be the status of the
+    // job, so they are held back until the connection is closed.
+    std::cout.flush();
+    bool succeeded = true;
+    std::string received;
+    char buffer[64 << 10];
+    for (;;) {
+        ssize_t count = read(connection, buffer, sizeof(buffer));
+        if (count < 0 && errno == EINTR) {
+            continue;
+        }
+        if (count <= 0) {
+            succeeded = (count == 0);
+            break;
+        }
+        received.append(buffer, static_cast<size_t>(count));
+        if (received.size() > TRAILER_SIZE) {
+            size_t size = received.size() - TRAILER_SIZE;
+            if (!OrderedWriter::writeFully(STDOUT_FILENO, received.data(), size)) {
+                succeeded = false;
+                break;
+            }
+            received.erase(0, size);
+        }
+    }
+    close(connection);
+
+    if (succeeded && received == FAILED_TRAILER) {
+        std::cerr << "ERROR: Job " << config_path << " couldn't write its results\n";
+        return false;
+    }
+    succeeded = succeeded && received == DONE_TRAILER;
+    if (!succeeded) {
+        std::cerr << "ERROR: Couldn't receive the results from " << socket_path << '\n';
+    }
+    return succeeded;
+}
@@ -0,0 +1,114 @@
+#pragma once
+
+#include "moduleCache.hpp"
+
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+
+class Executor;
+
+// Daemon executing the simulations submitted by clients over a UNIX domain
+// socket. The workers and the instances of the modules stay resident between
+// the jobs, so a short simulation doesn't pay for starting threads and
+// creating modules. Every job runs on a thread of its own and submits its
+// events to the workers shared by all jobs, which take the events of the
+// jobs running at the same time in turns.
+//
+// A job is submitted as key value pairs like a configuration file, ended by
+// an empty line or the end of the request:
+//     config = /path/to/simulation.conf     configuration of the simulation
+//     output_file = /path/to/results        optional output file replacing
+//                                           the one of the configuration
+// The server answers with a line "OK" once the simulation is initialized or
+// "ERROR: <reason>" if it can't be run. Results of a simulation without an
+// output file follow on the connection, which is closed once the simulation
+// is done. The connection ends with a status line of TRAILER_SIZE characters,
+// DONE_TRAILER if all results were written and FAILED_TRAILER otherwise, so a
+// client tells a complete job from one that failed or was cut off. Relative
+// paths of the configuration are relative to the working directory of the
+// server.
+//
+// A client has REQUEST_TIMEOUT_MS to send its request, requests not complete
+// by then or when the server stops are closed without an answer. At most
+// MAX_RUNNING_JOBS jobs run at the same time, further connections wait until
+// a job is done.
+//
+// The socket is only accessible by the user running the server. A job reads
+// and writes the files named by its configuration with the permissions of
+// that user, so anyone who can connect can use them.
+class Server
+{
+public:
+    // Factory method for creating servers listening on a socket.
+    // params: socket_path - The path of the UNIX domain socket, replaced if
+    //         left behind by a server that is no longer running.
+    // returns: pointer to the server or null if the socket can't be created.
+    static std::unique_ptr<Server> createServer(const std::string& socket_path);
+
+    // Closes and removes the socket.
+    ~Server();
+
+    // Copys are not allowed.
+    Server(const Server&) = delete;
+    Server& operator=(const Server&) = delete;
+
+    // Accept and run jobs until the process gets SIGINT or SIGTERM, then
+    // wait for the running jobs.
+    // returns: false if the server couldn't accept connections.
+    bool run();
+
+    // Submit a job to the server listening on the socket and copy the
+    // results it streams back to standard out.
+    // params: socket_path - The path of the socket of the server.
+    //         config_path - The configuration file of the simulation.
+    //         output_path - Optional output file of the results, empty to
+    //              use the one of the configuration or stream them back.
+    // returns: false if the job couldn't be submitted or run.
+    static bool submit(const std::string& socket_path, const std::string& config_path,
+        const std::string& output_path);
+
+private:
+    Server() = default;
+
+    // Read the request of a client, run its simulation and close the
+    // connection.
+    void runJob(int connection, Executor& executor);
+
+    // number of tasks waiting for execution per worker
+    static constexpr size_t PENDING_TASKS_PER_WORKER = 64;
+
+    // maximum size of a request
+    static constexpr size_t MAX_REQUEST_SIZE = 64 << 10;
+
+    // time a client has to send its request
+    static constexpr int REQUEST_TIMEOUT_MS = 10000;
+
+    // maximum number of jobs running at the same time
+    static constexpr size_t MAX_RUNNING_JOBS = 64;
+
+    // status lines ending the connection of a job, of the same size
+    static constexpr size_t TRAILER_SIZE = 15;
+    static constexpr const char* DONE_TRAILER = "FRAMEWORK DONE\n";
+    static constexpr const char* FAILED_TRAILER = "FRAMEWORK FAIL\n";
+
+    // path and descriptor of the listening socket
+    std::string socket_path_;
+    int socket_ {-1};
+
+    // instances of the modules kept between the jobs
+    ModuleCache module_cache_;
+
+    // number of jobs running, the server waits for them before stopping
+    size_t running_jobs_ {0};
+    std::mutex jobs_mutex_;
+    std::condition_variable jobs_done_;
+
+    // set once the server stops, requests still being read are abandoned
+    std::atomic<bool> stopping_ {false};
+
+    // keeps the reports of jobs running at the same time apart
+    std::mutex report_mutex_;
+};
@@ -0,0 +1,50 @@
+#include "sharedExecutor.hpp"
+
+SharedExecutor::SharedExecutor(std::unique_ptr<Executor>&& executor)
+    : executor_(std::move(executor))
+{
+}
+
+// Submits a task to the shared executor.
+void SharedExecutor::submit(TaskType&& task)
+{
+    beginTurn();
+    executor_->submit(std::move(task));
+    endTurn();
+}
+
+// Change the number of workers of the shared executor.
+bool SharedExecutor::setActiveWorkers(size_t number_of_workers, bool adapt)
+{
+    beginTurn();
+    bool changed = executor_->setActiveWorkers(number_of_workers, adapt);
+    endTurn();
+    return changed;
+}
+
+// Block waiting for the execution of the tasks of all simulations.
+void SharedExecutor::execute()
+{
+    beginTurn();
+    executor_->execute();
+    endTurn();
+}
+
+// Wait for the turn of the caller, turns are given out in the order the
+// callers arrive.
+void SharedExecutor::beginTurn()
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    uint64_t turn = next_turn_++;
+    turn_.wait(lock, [this, turn]() { return current_turn_ == turn; });
+}
+
+// Pass the turn on to the next caller waiting.
+void SharedExecutor::endTurn()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        ++current_turn_;
+    }
+    turn_.notify_all();
+}
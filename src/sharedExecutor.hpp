@@ -0,0 +1,62 @@
+#pragma once
+
+#include "executor.hpp"
+
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+
+// Executor shared by simulations running at the same time, e.g. the
+// simulations of a sweep. The executors expect a single thread submitting
+// tasks, so the submissions of the simulations are taken one at a time and
+// handed to the executor owning the workers. Submissions take turns in the
+// order they arrive, so while the queue is full every simulation waiting to
+// submit gets the next free place in turn and a simulation submitting many
+// events can't keep the others waiting.
+//
+// Simulations using a shared executor wait for their own tasks instead of
+// finishing the executor, which is finished by its owner once all
+// simulations are done.
+class SharedExecutor : public Executor
+{
+public:
+    // Share the given executor.
+    explicit SharedExecutor(std::unique_ptr<Executor>&& executor);
+
+    // Copys are not allowed.
+    SharedExecutor(const SharedExecutor&) = delete;
+    SharedExecutor& operator=(const SharedExecutor&) = delete;
+
+    // Submits a task to the shared executor. Blocks the caller while another
+    // thread submits or while the queue of the executor is full.
+    void submit(TaskType&& task) override;
+
+    // Change the number of workers of the shared executor.
+    bool setActiveWorkers(size_t number_of_workers, bool adapt) override;
+
+    // Block waiting for the execution of the tasks of all simulations.
+    // Any tasks submitted after this call will not be executed.
+    void execute() override;
+
+private:
+    // Wait for the turn of the caller to use the executor.
+    void beginTurn();
+
+    // Pass the turn on to the next caller waiting.
+    void endTurn();
+
+    // executor owning the workers
+    std::unique_ptr<Executor> executor_;
+
+    // serializes the submissions of the simulations
+    std::mutex mutex_;
+
+    // signaled when the turn passes on
+    std::condition_variable turn_;
+
+    // turn given to the next caller and turn of the caller using the
+    // executor
+    uint64_t next_turn_ {0};
+    uint64_t current_turn_ {0};
+};
@@ -1,18 +1,108 @@
 #include "simulation.hpp"
+#include "binaryFormat.hpp"
+#include "checkpoint.hpp"
+#include "cpuTopology.hpp"
 #include "event.hpp"
-#include "threadPool.hpp"
+#include "executor.hpp"
+#include "inputFile.hpp"
+#include "instrumentation.hpp"
+#include "moduleCache.hpp"
+#include "modulePipeline.hpp"
+#include "orderedWriter.hpp"
+#include "outputSink.hpp"
+#include "resultCache.hpp"
+#include "summary.hpp"
 
-#include <array>
+#ifdef STATIC_PIPELINE_MODULES
+#include "staticPipeline.hpp"
+#include "module1.hpp"
+#include "module2.hpp"
+#include "module3.hpp"
+#include "module4.hpp"
+#include "module5.hpp"
+
+// modules compiled into a static pipeline, configured with the cmake option
+// FRAMEWORK_STATIC_PIPELINE. Used when the configuration loads exactly
+// these modules in this order.
+using CompiledPipeline = StaticPipeline<STATIC_PIPELINE_MODULES>;
+#endif
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
 #include <iostream>
+#include <sstream>
 #include <chrono>
 using namespace std::chrono_literals;
 
+// definitions of the constants passed by reference to std::min and std::max
+constexpr size_t Simulation::PENDING_EVENTS_PER_THREAD;
+constexpr size_t Simulation::MIN_OUTPUT_WINDOW;
+constexpr size_t Simulation::OUTPUT_WINDOW_PER_THREAD;
+constexpr size_t Simulation::TASKS_PER_THREAD;
+constexpr size_t Simulation::MAX_GRAIN_SIZE;
+constexpr size_t Simulation::SLOTS_PER_STAGE;
+
+// Instances of the modules executing the events of a run on one thread.
+struct Simulation::ThreadModules {
+#ifdef STATIC_PIPELINE_MODULES
+    // modules of the compiled pipeline, used when they match the loaded ones
+    CompiledPipeline pipeline;
+#endif
+
+    // instances of the loaded modules owned by the thread
+    std::vector<std::shared_ptr<Module>> instances;
+
+    // modules in the order of the loaded modules
+    std::vector<Module*> modules;
+
+    // aggregates of the values of the events executed by the thread, when
+    // only the summary of the run is written
+    Summary summary;
+};
+
+namespace {
+    // number of the next run of any simulation in the process
+    std::atomic<uint64_t> next_run_number {1};
+}
+
 Simulation::Simulation(const Configuration& config)
-        : config_(config), number_of_events_(config_.getNumberOfEvents())
+        : config_(config), first_event_(config_.getFirstEvent())
 {
-    std::cout << "INFO: Using seed= " << config_.getInitialSeed() << std::endl;
+    // by default as many threads as CPUs are available, the number actually
+    // running is chosen while running
+    number_of_threads_ = config_.useAutomaticThreads()
+        ? CpuTopology::getAvailableCpus() : config_.getNumberOfThreads();
+
+    std::cout << "INFO: Using seed= " << config_.getInitialSeed() << '\n';
+
+    if (config_.getLastEvent() >= first_event_) {
+        number_of_events_ = config_.getLastEvent() - first_event_ + 1;
+    }
 
     random_engine_.seed(config_.getInitialSeed());
+
+    // skip the seeds of the events before the first one to execute
+    if (!config_.useCounterSeeding()) {
+        random_engine_.discard(first_event_ - 1);
+    }
+}
+
+Simulation::~Simulation()
+{
+    if (output_fd_ >= 0) {
+        close(output_fd_);
+    }
+
+    // keep the loaded modules for the following simulations
+    if (module_cache_) {
+        std::vector<std::string> module_names = config_.getModuleNames();
+        for (size_t m = 0; m < modules_.size(); ++m) {
+            module_cache_->release(module_names[m], ModuleCache::Use::LOADED, std::move(modules_[m]));
+        }
+    }
 }
 
 // Initialize the simulation modules.
@@ -20,62 +110,1270 @@ bool Simulation::init()
 {
     std::vector<std::string> modules_to_load = config_.getModuleNames();
 
+    // check the random number engine of the events exists
+    if (!RandomEngine::createRandomEngine(config_.getRandomEngine())) {
+        std::cerr << "ERROR: Invalid random engine name: " << config_.getRandomEngine() << std::endl;
+        return false;
+    }
+    random_engine_name_ = config_.getRandomEngine();
+
     // try to create the correct modules
     for (const std::string& module_name : modules_to_load) {
-        std::shared_ptr<Module> module = Module::createModule(module_name);
-        if (module) {
-            std::cout << "INFO: Loaded module: " << module_name << std::endl;
-            modules_.push_back(module);
-        } else {
-            std::cerr << "ERROR: Invalid Modules name: " << module_name << std::endl;
+        // cached modules were initialized by an earlier simulation
+        std::shared_ptr<Module> module;
+        if (module_cache_) {
+            module = module_cache_->acquire(module_name, ModuleCache::Use::LOADED);
+        }
+        if (!module) {
+            module = Module::createModule(module_name);
+            if (!module) {
+                std::cerr << "ERROR: Invalid Modules name: " << module_name << std::endl;
+                return false;
+            }
+            if (!module->initialize()) {
+                std::cerr << "ERROR: Couldn't initialize module: " << module_name << std::endl;
+                return false;
+            }
+        }
+        std::cout << "INFO: Loaded module: " << module_name << '\n';
+        modules_.push_back(module);
+    }
+
+#ifdef STATIC_PIPELINE_MODULES
+    use_compiled_pipeline_ = (CompiledPipeline().getModuleNames() == modules_to_load);
+#endif
+
+    // the results of the leading modules supporting it are kept in the
+    // result cache, which executes the modules one event at a time
+    if (!config_.getResultCache().empty()) {
+        result_cache_ = ResultCache::createResultCache(config_.getResultCache(),
+            static_cast<uint64_t>(config_.getResultCacheSize()) << 20);
+        if (!result_cache_) {
+            return false;
+        }
+        while (cached_modules_ < modules_.size() && modules_[cached_modules_]->supportsResultCache()) {
+            ++cached_modules_;
+        }
+        result_cache_key_ = "engine " + random_engine_name_
+            + (config_.useCounterSeeding() ? " counter" : " sequential")
+            + " seed " + std::to_string(config_.getInitialSeed());
+        use_compiled_pipeline_ = false;
+    }
+
+    // execute blocks of events when configured, or when all modules
+    // implement the block interface unless they are compiled into a static
+    // pipeline or their results are cached
+    use_event_blocks_ = (config_.getExecution() == "blocks");
+    if (config_.getExecution() == "auto" && !use_compiled_pipeline_ && !result_cache_) {
+        use_event_blocks_ = std::all_of(modules_.begin(), modules_.end(),
+            [](const std::shared_ptr<Module>& module) { return module->supportsBlocks(); });
+    }
+
+    // the modules of an event executed as a graph start once the modules
+    // they depend on are done, so the number executing at once is at most
+    // the number of modules at the same depth of the graph
+    if (config_.useGraphExecution()) {
+        std::vector<std::vector<unsigned int>> dependencies = config_.getModuleDependencies();
+        module_dependents_.assign(modules_.size(), std::vector<size_t>());
+        module_dependency_counts_.assign(modules_.size(), 0);
+        std::vector<size_t> depths(modules_.size(), 0);
+        std::vector<size_t> modules_per_depth(modules_.size(), 0);
+        for (size_t m = 0; m < modules_.size(); ++m) {
+            std::sort(dependencies[m].begin(), dependencies[m].end());
+            dependencies[m].erase(std::unique(dependencies[m].begin(), dependencies[m].end()),
+                dependencies[m].end());
+
+            // the dependencies come before the module in the configuration
+            module_dependency_counts_[m] = dependencies[m].size();
+            for (unsigned int dependency : dependencies[m]) {
+                module_dependents_[dependency].push_back(m);
+                depths[m] = std::max(depths[m], depths[dependency] + 1);
+            }
+            ++modules_per_depth[depths[m]];
+        }
+        graph_width_ = *std::max_element(modules_per_depth.begin(), modules_per_depth.end());
+    }
+
+    // the records of the events are read from the input file, event number
+    // n reads record n - 1
+    if (!config_.getInputFile().empty()) {
+        input_ = InputFile::createInputFile(config_.getInputFile(), config_.getInputRecordSize());
+        if (!input_) {
+            return false;
+        }
+        if (input_->getNumberOfRecords() < config_.getLastEvent()) {
+            std::cerr << "ERROR: Input file has " << input_->getNumberOfRecords()
+                << " records, fewer than the events" << std::endl;
+            return false;
+        }
+    }
+
+    // binary results refer to the modules by index in their distinct names
+    if (config_.getOutputFormat() == "binary") {
+        output_format_ = OutputSink::Format::BINARY;
+    } else if (config_.getOutputFormat() == "summary") {
+        output_format_ = OutputSink::Format::SUMMARY;
+    }
+    for (const std::string& module_name : modules_to_load) {
+        if (std::find(output_modules_.begin(), output_modules_.end(), module_name) == output_modules_.end()) {
+            output_modules_.push_back(module_name);
+        }
+    }
+
+    // a pipeline runs a thread per stage, placed like the workers
+    if (config_.usePipelineExecution()) {
+        chooseStages();
+        number_of_threads_ = stages_.size();
+    }
+
+    // place the workers on the CPUs of the machine, unless they belong to a
+    // shared executor
+    if (!shared_executor_ && config_.getWorkerAffinity() != "none" && !chooseWorkerPlacement()) {
+        return false;
+    }
+
+    if (!config_.getOutputFile().empty()) {
+        return openOutputFile();
+    }
+
+    return true;
+}
+
+// Group the modules into the stages of the pipeline, consecutive modules
+// each as configured or one module per stage.
+void Simulation::chooseStages()
+{
+    std::vector<unsigned int> stage_sizes = config_.getPipelineStages();
+    if (stage_sizes.empty()) {
+        stage_sizes.assign(modules_.size(), 1);
+    }
+
+    size_t module = 0;
+    for (unsigned int size : stage_sizes) {
+        stages_.emplace_back();
+        for (unsigned int i = 0; i < size; ++i) {
+            stages_.back().push_back(module++);
+        }
+    }
+}
+
+// Choose the CPUs the workers are pinned to. With cpu affinity every worker
+// gets one CPU, filling one NUMA node after the other. With node affinity
+// the workers are spread evenly over the nodes, each pinned to all CPUs of
+// its node and sharing a queue with the workers of its node only.
+bool Simulation::chooseWorkerPlacement()
+{
+    CpuTopology topology = CpuTopology::detect();
+    if (!config_.getWorkerCpus().empty()) {
+        std::vector<int> cpus;
+        if (!CpuTopology::parseCpuList(config_.getWorkerCpus(), cpus)) {
+            std::cerr << "ERROR: Invalid list of worker CPUs: " << config_.getWorkerCpus() << std::endl;
+            return false;
+        }
+        topology.restrict(cpus);
+        if (topology.getNodes().empty()) {
+            std::cerr << "ERROR: None of the worker CPUs are available: " << config_.getWorkerCpus() << std::endl;
             return false;
         }
     }
 
+    size_t number_of_workers = number_of_threads_;
+    const std::vector<std::vector<int>>& nodes = topology.getNodes();
+    if (config_.getWorkerAffinity() == "cpu") {
+        std::vector<int> cpus = topology.getCpus();
+        for (size_t i = 0; i < number_of_workers; ++i) {
+            placement_.worker_cpus.push_back({cpus[i % cpus.size()]});
+        }
+    } else {
+        for (size_t node = 0; node < nodes.size(); ++node) {
+            size_t size = number_of_workers / nodes.size() + (node < number_of_workers % nodes.size() ? 1 : 0);
+            if (size > 0) {
+                placement_.partitions.push_back(size);
+                placement_.worker_cpus.insert(placement_.worker_cpus.end(), size, nodes[node]);
+            }
+        }
+    }
+
+    // without thread affinity the workers run unpinned. The affinity is only
+    // read, the thread calling the simulation keeps its own.
+    if (!CpuTopology::supportsAffinity()) {
+        std::cerr << "WARNING: Thread affinity is not available, workers are not pinned" << std::endl;
+        placement_.worker_cpus.clear();
+    }
+
     return true;
 }
 
+// Open the output file of the configuration. When resuming, the results of
+// the events before the checkpoint are kept and the simulation continues
+// from the next event.
+bool Simulation::openOutputFile()
+{
+    uint64_t resume_offset = 0;
+    if (!config_.getCheckpointFile().empty()) {
+        checkpoint_.reset(new Checkpoint(config_));
+
+        // a missing checkpoint means the earlier run didn't get far
+        Checkpoint saved(config_);
+        if (resume_ && saved.read(config_.getCheckpointFile())) {
+            if (!saved.matches(*checkpoint_)) {
+                std::cerr << "ERROR: Checkpoint " << config_.getCheckpointFile()
+                    << " was taken with a different configuration" << std::endl;
+                return false;
+            }
+            checkpoint_.reset(new Checkpoint(saved));
+            resume_offset = saved.getOutputOffset();
+        }
+    }
+
+    int flags = O_RDWR | O_CREAT | (resume_offset == 0 ? O_TRUNC : 0);
+    output_fd_ = open(config_.getOutputFile().c_str(), flags, 0644);
+    if (output_fd_ < 0) {
+        std::cerr << "ERROR: Couldn't open output file " << config_.getOutputFile() << std::endl;
+        return false;
+    }
+
+    if (resume_offset > 0) {
+        // drop the output written after the checkpoint
+        output_offset_ = resume_offset;
+        if (ftruncate(output_fd_, static_cast<off_t>(output_offset_)) != 0
+                || lseek(output_fd_, static_cast<off_t>(output_offset_), SEEK_SET) < 0) {
+            std::cerr << "ERROR: Couldn't resume output file " << config_.getOutputFile() << std::endl;
+            return false;
+        }
+
+        if (output_format_ == OutputSink::Format::BINARY) {
+            std::ostringstream header;
+            uint64_t header_size = BinaryFormat::writeFileHeader(header, output_modules_);
+            if (!readResumedIndex(header_size, output_offset_)) {
+                std::cerr << "ERROR: Couldn't resume output file " << config_.getOutputFile() << std::endl;
+                return false;
+            }
+        }
+
+        // continue from the next event with the seeds it has in a full run
+        first_event_ = checkpoint_->getNextEvent();
+        number_of_events_ = config_.getLastEvent() >= first_event_
+            ? config_.getLastEvent() - first_event_ + 1 : 0;
+        random_engine_.seed(config_.getInitialSeed());
+        if (!config_.useCounterSeeding()) {
+            random_engine_.discard(first_event_ - 1);
+        }
+        std::cout << "INFO: Resuming from event " << first_event_ << '\n';
+    }
+
+    return true;
+}
+
+// Read the index entries of the blocks in the output file before the
+// checkpoint. Blocks follow each other from the end of the header.
+bool Simulation::readResumedIndex(uint64_t header_size, uint64_t output_offset)
+{
+    uint64_t offset = header_size;
+    while (offset < output_offset) {
+        BinaryFormat::BlockHeader header;
+        if (pread(output_fd_, &header, sizeof(header), static_cast<off_t>(offset)) != sizeof(header)
+                || header.magic != BinaryFormat::BLOCK_MAGIC) {
+            return false;
+        }
+
+        BinaryFormat::IndexEntry entry {header.first_event, header.number_of_events, offset};
+        resumed_index_.append(reinterpret_cast<const char*>(&entry), sizeof(entry));
+        offset += BinaryFormat::getBlockSize(header);
+    }
+
+    return offset == output_offset;
+}
+
 // Run the simulation using the specified number of events.
-void Simulation::run()
+bool Simulation::run()
+{
+    // results are written to the file descriptor bypassing standard out, so
+    // the messages buffered in it go out first
+    std::cout.flush();
+    return run(nullptr, output_fd_ >= 0 ? output_fd_ : STDOUT_FILENO);
+}
+
+// Run the simulation writing the event results to the given stream.
+bool Simulation::run(std::ostream& output)
+{
+    return run(&output, -1);
+}
+
+// Run the simulation writing the event results to the file descriptor.
+bool Simulation::run(int fd)
+{
+    return run(nullptr, output_fd_ >= 0 ? output_fd_ : fd);
+}
+
+// Run the simulation writing the event results to the stream if any or to
+// the file descriptor.
+bool Simulation::run(std::ostream* stream, int fd)
 {
-    ThreadPool thread_pool(config_.getNumberOfThreads());
-    std::vector<std::future<std::string>> simulation_results(number_of_events_);
+    size_t number_of_threads = number_of_threads_;
+
+    // the threads create their instances of the modules for this run
+    run_number_ = next_run_number++;
+    cached_results_ = 0;
+    executed_results_ = 0;
+    for (const std::shared_ptr<Module>& module : modules_) {
+        module->beginRun(first_event_, number_of_events_);
+    }
+
+    // events are executed in batches of consecutive events, one task each
+    grain_size_ = chooseGrainSize();
+    batch_offset_ = result_cache_ ? (first_event_ - 1) % grain_size_ : 0;
+    size_t number_of_batches = (number_of_events_ + batch_offset_ + grain_size_ - 1) / grain_size_;
+
+    // limit the number of events waiting for execution so the memory used
+    // by the queue doesn't grow with the number of events
+    size_t max_pending_events = config_.getMaxPendingEvents();
+    if (max_pending_events == 0) {
+        max_pending_events = std::max<size_t>(1, number_of_threads) * PENDING_EVENTS_PER_THREAD;
+    }
+    size_t max_pending_batches = std::max<size_t>(1, max_pending_events / grain_size_);
+
+    // the modules are executed either by a pipeline of their stages passing
+    // the batches on in order, or as whole events by the executor
+    std::unique_ptr<ModulePipeline> pipeline;
+    std::unique_ptr<Executor> own_executor;
+    Executor* executor = shared_executor_;
+    if (!stages_.empty()) {
+        max_pending_batches = stages_.size() * SLOTS_PER_STAGE;
+        pipeline_slots_.resize(max_pending_batches);
+        for (PipelineSlot& slot : pipeline_slots_) {
+            slot.results.resize(grain_size_);
+            for (OutputSink& result : slot.results) {
+                result.setFormat(output_format_, &output_modules_);
+            }
+            slot.random_engines.resize(grain_size_);
+            for (std::unique_ptr<RandomEngine>& random_engine : slot.random_engines) {
+                random_engine = RandomEngine::createRandomEngine(random_engine_name_);
+            }
+            slot.batch_result.setFormat(output_format_, &output_modules_);
+        }
+        pipeline.reset(new ModulePipeline(stages_.size(), max_pending_batches,
+            [this](size_t stage, size_t slot, size_t batch) {
+                runStage(stage, slot, batch);
+            }, placement_.worker_cpus));
+    } else if (!executor) {
+        own_executor = Executor::createExecutor(config_.getScheduler(),
+            number_of_threads, max_pending_batches, instrumentation_, placement_);
+        executor = own_executor.get();
+    }
+
+    // with an automatic number of threads the first batch is executed on
+    // this thread to measure the cost of the events before starting workers.
+    // Executors whose workers can't be parked, e.g. the work stealing pool,
+    // execute it on their workers, so they use all threads instead.
+    bool warming_up = own_executor && config_.useAutomaticThreads() && number_of_threads > 0
+        && executor->setActiveWorkers(0, false);
+    bool inline_execution = warming_up || number_of_threads == 0;
+
+    // results are streamed to the output in event order as soon as they
+    // are ready, only a bounded window of them is held in memory. The window
+    // covers the pending batches and the ones being executed so the queue
+    // limit is the one applying back pressure on the submission.
+    size_t window_events = std::max<size_t>(MIN_OUTPUT_WINDOW,
+        max_pending_events + OUTPUT_WINDOW_PER_THREAD * number_of_threads);
+    size_t window_size = std::max<size_t>(max_pending_batches + number_of_threads,
+        window_events / grain_size_);
+
+    // binary results start with the header of the file and every batch is
+    // encoded in a block
+    bool output_failed = false;
+    if (output_format_ == OutputSink::Format::BINARY) {
+        if (output_offset_ == 0) {
+            std::ostringstream header;
+            output_offset_ = BinaryFormat::writeFileHeader(header, output_modules_);
+            output_failed = !writeOutput(stream, fd, header.str());
+        }
+        block_sizes_.assign(number_of_batches, 0);
+    }
+
+    if (stream) {
+        writer_.reset(new OrderedWriter(*stream, number_of_batches, window_size, instrumentation_));
+    } else {
+        writer_.reset(new OrderedWriter(fd, number_of_batches, window_size, instrumentation_));
+    }
+
+    // periodically save the progress of the run
+    if (checkpoint_ && !stream) {
+        next_checkpoint_event_ = first_event_ + config_.getCheckpointInterval();
+        writer_->setFlushCallback([this](size_t batches_written, uint64_t bytes_written) {
+            saveCheckpoint(batches_written, output_offset_ + bytes_written, false);
+        });
+    }
+    if (!config_.useCounterSeeding()) {
+        event_seeds_.assign(window_size * grain_size_, 0);
+    }
+
+    // the batches in flight executed as graphs, written before their slot
+    // is reused
+    if (config_.useGraphExecution()) {
+        graph_batches_.resize(window_size);
+        for (std::unique_ptr<GraphBatch>& graph : graph_batches_) {
+            graph.reset(new GraphBatch());
+        }
+    }
+
+    // timing statistics of the submission, if recorded
+    Instrumentation::ThreadStatistics* statistics = nullptr;
+    if (instrumentation_) {
+        statistics = &instrumentation_->local("main");
+        submit_times_.assign(window_size, 0);
+    }
 
     // submit the requested number of events to work queue
-    for (unsigned int i = 0; i < number_of_events_; ++i) {
-        // generate a random number for each event
-        unsigned int seed = random_engine_();
-        
-        // construct a new event object
-        simulation_results[i] = thread_pool.submit([this](const Event& e) {
-            ////// Event execution function begins ///////
+    for (size_t batch = 0; batch < number_of_batches; ++batch) {
+        size_t first, last;
+        getBatchEvents(batch, first, last);
+        int64_t submit_start = statistics ? Instrumentation::now() : 0;
+
+        // wait for a free slot in the output window
+        writer_->reserve(batch);
+
+        // have the records of the events read before the workers need them
+        if (input_) {
+            input_->readAhead(first_event_ - 1 + first);
+        }
+
+        // generate a random number for each event. Counter based seeds are
+        // derived by the task itself so there is nothing to do in sequence.
+        if (!config_.useCounterSeeding()) {
+            for (size_t i = first; i < last; ++i) {
+                event_seeds_[i % event_seeds_.size()] = random_engine_();
+            }
+        }
+
+        if (statistics) {
+            submit_times_[batch % submit_times_.size()] = Instrumentation::now();
+        }
+
+        std::chrono::steady_clock::time_point warm_up_start;
+        if (warming_up) {
+            warm_up_start = std::chrono::steady_clock::now();
+        }
+
+        // a batch executed as a graph is shared by as many tasks as threads
+        // can execute its modules at once
+        size_t number_of_tasks = 1;
+        if (!graph_batches_.empty()) {
+            prepareGraph(batch);
+            number_of_tasks = std::min(std::max<size_t>(1, number_of_threads), (last - first) * graph_width_);
+        }
+
+        if (pipeline) {
+            pipeline->submit(batch);
+        } else if (!graph_batches_.empty()) {
+            for (size_t task = 0; task < number_of_tasks; ++task) {
+                if (own_executor) {
+                    executor->submit([this, batch]() {
+                        runGraph(batch);
+                    });
+                } else {
+                    {
+                        std::lock_guard<std::mutex> lock(batches_mutex_);
+                        ++pending_batches_;
+                    }
+                    executor->submit([this, batch]() {
+                        runGraph(batch);
+                        finishBatch();
+                    });
+                }
+            }
+        } else if (own_executor) {
+            executor->submit([this, batch]() {
+                runBatch(batch);
+            });
+        } else {
+            // the shared executor isn't finished by this run, which counts
+            // its batches to wait for them
+            {
+                std::lock_guard<std::mutex> lock(batches_mutex_);
+                ++pending_batches_;
+            }
+            executor->submit([this, batch]() {
+                runBatch(batch);
+                finishBatch();
+            });
+        }
+
+        if (warming_up) {
+            std::chrono::nanoseconds warm_up_time = std::chrono::steady_clock::now() - warm_up_start;
+            size_t number_of_workers = chooseNumberOfWorkers(warm_up_time.count(), last);
+            executor->setActiveWorkers(number_of_workers, true);
+            warming_up = false;
+            inline_execution = (number_of_workers == 0);
+        }
+
+        // without workers the batch was executed by the submission itself
+        if (statistics && !inline_execution) {
+            int64_t submit_end = Instrumentation::now();
+            statistics->submit_time.record(static_cast<uint64_t>(submit_end - submit_start));
+            statistics->recordSpan("submit", batch, submit_start, submit_end);
+        }
+    }
+
+    // execute the simulation using specified number of threads
+    if (pipeline) {
+        pipeline->finish();
+        pipeline.reset();
+        pipeline_slots_.clear();
+    } else if (own_executor) {
+        own_executor->execute();
+    } else {
+        std::unique_lock<std::mutex> lock(batches_mutex_);
+        batches_done_.wait(lock, [this]() {
+            return pending_batches_ == 0;
+        });
+    }
+    graph_batches_.clear();
+
+    // wait for the remaining results to be written to the output
+    writer_->close();
+    finalizeModules();
+    if (result_cache_) {
+        std::cout << "INFO: Took " << cached_results_ << " of " << cached_results_ + executed_results_
+            << " module results from the result cache\n";
+    }
+    output_failed = output_failed || writer_->failed();
+    writer_.reset();
+
+    if (output_format_ == OutputSink::Format::SUMMARY) {
+        output_failed = output_failed || !writeOutput(stream, fd, summary_.format(output_modules_));
+    }
 
-            // per thread random number generator
-            static thread_local std::mt19937 thread_random_generator_;
+    // the last checkpoint covers all events, resuming only rewrites the index
+    if (checkpoint_ && !stream && !output_failed) {
+        saveCheckpoint(number_of_batches, static_cast<uint64_t>(lseek(fd, 0, SEEK_CUR)), true);
+    }
 
-            // event result that will be saved in the shared future state
-            std::string event_result;
+    if (output_format_ == OutputSink::Format::BINARY) {
+        output_failed = output_failed || !writeOutput(stream, fd, encodeIndex(output_offset_));
+    }
+
+    if (output_failed) {
+        std::cerr << "ERROR: Couldn't write the results" << std::endl;
+    }
+    return !output_failed;
+}
+
+// Execute the events of the given batch and hand their results to the writer.
+void Simulation::runBatch(size_t batch)
+{
+    // instances of the modules of this thread
+    ThreadModules& thread_modules = getThreadModules();
+
+    // per thread random number generator of the configured type
+    static thread_local std::unique_ptr<RandomEngine> thread_random_generator_;
+    if (!thread_random_generator_ || random_engine_name_ != thread_random_generator_->getName()) {
+        thread_random_generator_ = RandomEngine::createRandomEngine(random_engine_name_);
+    }
+
+    size_t first, last;
+    getBatchEvents(batch, first, last);
+
+    // results of all events of the batch that will be handed to the writer.
+    // The buffer is reused by all batches executed by this thread.
+    static thread_local OutputSink batch_result;
+    batch_result.setFormat(output_format_, &output_modules_);
+
+    // timing statistics of this thread, if recorded
+    Instrumentation::ThreadStatistics* statistics = nullptr;
+    int64_t batch_start = 0;
+    int64_t event_start = 0;
+    if (instrumentation_) {
+        statistics = &instrumentation_->local();
+        batch_start = Instrumentation::now();
+        event_start = batch_start;
+        statistics->queue_wait.record(static_cast<uint64_t>(
+            batch_start - submit_times_[batch % submit_times_.size()]));
+    }
+
+    if (use_event_blocks_) {
+        runBlocks(first, last, thread_modules, batch_result);
+    } else if (result_cache_) {
+        runCachedEvents(first, last, thread_modules, *thread_random_generator_, batch_result);
+    } else {
+        for (size_t i = first; i < last; ++i) {
+            ////// Event execution function begins ///////
+
+            // construct a new event object
+            Event e = createEvent(i);
+            batch_result.beginEvent(e.getNumber());
 
             // use the seed specific to the current event
-            thread_random_generator_.seed(e.getSeed());
+            thread_random_generator_->seed(e.getSeed());
 
             // simulate the event
-            for (auto &module : modules_) {
-                event_result += module->run(e, &thread_random_generator_);
-                //std::this_thread::sleep_for(100ms);
+#ifdef STATIC_PIPELINE_MODULES
+            if (use_compiled_pipeline_) {
+                thread_modules.pipeline.run(e, *thread_random_generator_, batch_result);
+            } else
+#endif
+            if (statistics) {
+                // time each module separately
+                int64_t module_start = Instrumentation::now();
+                for (size_t m = 0; m < thread_modules.modules.size(); ++m) {
+                    thread_modules.modules[m]->run(e, thread_random_generator_.get(), batch_result);
+                    int64_t module_end = Instrumentation::now();
+                    statistics->recordModule(m, static_cast<uint64_t>(module_end - module_start));
+                    module_start = module_end;
+                }
+            } else {
+                for (Module* module : thread_modules.modules) {
+                    module->run(e, thread_random_generator_.get(), batch_result);
+                    //std::this_thread::sleep_for(100ms);
+                }
             }
+            batch_result.endEvent();
 
-            return event_result;
             //// Event execution function ends //////
-        }, Event{i+1, seed});
+
+            if (statistics) {
+                int64_t event_end = Instrumentation::now();
+                statistics->event_time.record(static_cast<uint64_t>(event_end - event_start));
+                event_start = event_end;
+            }
+        }
     }
 
-    // execute the simulation using specified number of threads
-    thread_pool.execute();
+    batch_result.finish();
+    if (output_format_ == OutputSink::Format::BINARY) {
+        block_sizes_[batch] = batch_result.size();
+    } else if (output_format_ == OutputSink::Format::SUMMARY) {
+        thread_modules.summary.merge(batch_result.getSummary());
+    }
+
+    if (statistics) {
+        int64_t result_start = Instrumentation::now();
+        writer_->write(batch, batch_result.data(), batch_result.size());
+        int64_t result_end = Instrumentation::now();
+        statistics->result_time.record(static_cast<uint64_t>(result_end - result_start));
+        statistics->recordSpan("batch", batch, batch_start, result_end);
+    } else {
+        writer_->write(batch, batch_result.data(), batch_result.size());
+    }
+}
+
+// Returns the event with the given index in the run, with its number, seed
+// and record of the input file.
+Event Simulation::createEvent(size_t i) const
+{
+    unsigned int number = static_cast<unsigned int>(first_event_ + i);
+    unsigned int seed = config_.useCounterSeeding()
+        ? deriveSeed(config_.getInitialSeed(), number)
+        : event_seeds_[i % event_seeds_.size()];
+
+    const char* record = nullptr;
+    size_t record_size = 0;
+    if (input_) {
+        input_->getRecord(number - 1, record, record_size);
+    }
+    return Event(number, seed, record, record_size);
+}
+
+// Execute the events from first to last in blocks, each module executing a
+// block of events at once with the streams of the events advanced together.
+// The results of every event are collected on their own and appended to the
+// batch result in the order of the events.
+void Simulation::runBlocks(size_t first, size_t last, ThreadModules& thread_modules, OutputSink& batch_result)
+{
+    const size_t lanes = MultiStreamEngine::LANES;
+
+    // per thread random number streams of the configured type
+    static thread_local std::unique_ptr<MultiStreamEngine> thread_random_streams;
+    if (!thread_random_streams || random_engine_name_ != thread_random_streams->getName()) {
+        thread_random_streams = MultiStreamEngine::createMultiStreamEngine(random_engine_name_);
+    }
+
+    // results of the events of a block, reused by all blocks of this thread.
+    // Summaries don't depend on the order of the events, so every lane
+    // aggregates the events of all blocks and is merged once at the end.
+    bool summary = (output_format_ == OutputSink::Format::SUMMARY);
+    static thread_local std::vector<OutputSink> event_results(lanes);
+    for (OutputSink& event_result : event_results) {
+        event_result.setFormat(output_format_, &output_modules_);
+    }
+
+    // timing statistics of this thread, if recorded. The time of a block
+    // is shared evenly by its events.
+    Instrumentation::ThreadStatistics* statistics = nullptr;
+    if (instrumentation_) {
+        statistics = &instrumentation_->local();
+    }
+
+    unsigned int numbers[lanes];
+    unsigned int seeds[lanes];
+    const char* records[lanes];
+    size_t record_sizes[lanes];
+    EventBlock block;
+    block.numbers = numbers;
+    block.seeds = seeds;
+    block.records = records;
+    block.record_sizes = record_sizes;
+    block.outputs = event_results.data();
+
+    for (size_t block_first = first; block_first < last; block_first += lanes) {
+        block.size = std::min(lanes, last - block_first);
+        for (size_t i = 0; i < block.size; ++i) {
+            Event e = createEvent(block_first + i);
+            numbers[i] = e.getNumber();
+            seeds[i] = e.getSeed();
+            records[i] = e.getRecord();
+            record_sizes[i] = e.getRecordSize();
+            if (!summary) {
+                event_results[i].clear();
+            }
+            event_results[i].beginEvent(numbers[i]);
+        }
+        thread_random_streams->seed(seeds, block.size);
+
+        if (statistics) {
+            int64_t block_start = Instrumentation::now();
+            int64_t module_start = block_start;
+            for (size_t m = 0; m < thread_modules.modules.size(); ++m) {
+                thread_modules.modules[m]->runBlock(block, *thread_random_streams);
+                int64_t module_end = Instrumentation::now();
+                for (size_t i = 0; i < block.size; ++i) {
+                    statistics->recordModule(m, static_cast<uint64_t>(module_end - module_start) / block.size);
+                }
+                module_start = module_end;
+            }
+            for (size_t i = 0; i < block.size; ++i) {
+                statistics->event_time.record(static_cast<uint64_t>(module_start - block_start) / block.size);
+            }
+        } else {
+            for (Module* module : thread_modules.modules) {
+                module->runBlock(block, *thread_random_streams);
+            }
+        }
+
+        for (size_t i = 0; i < block.size && !summary; ++i) {
+            event_results[i].endEvent();
+            batch_result.appendEvents(event_results[i]);
+        }
+    }
+
+    for (size_t i = 0; i < lanes && summary; ++i) {
+        batch_result.appendEvents(event_results[i]);
+    }
+}
+
+// Execute the events from first to last one at a time, taking the results of
+// the longest prefix of the cached modules found in the result cache. The
+// stream of every event continues at the position it had after the prefix,
+// and the results of the cached modules executed are recorded and kept in
+// the cache for the following runs.
+void Simulation::runCachedEvents(size_t first, size_t last, ThreadModules& thread_modules,
+    RandomEngine& random_engine, OutputSink& batch_result)
+{
+    CountingEngine counting_engine(random_engine);
+
+    // results of the cached modules for the events of the batch, reused by
+    // all batches of this thread
+    static thread_local std::vector<ResultCache::Entry> entries;
+    static thread_local OutputSink recorded;
+    entries.resize(std::max(entries.size(), cached_modules_));
+    recorded.setFormat(OutputSink::Format::RECORDED);
+
+    // the results of a module depend on all modules before it, the key of
+    // every module names them all. The events are named by their numbers,
+    // so runs starting at other events or shards share the entries.
+    std::vector<std::string> keys(cached_modules_);
+    std::string key = result_cache_key_ + " events " + std::to_string(first_event_ + first)
+        + ' ' + std::to_string(last - first) + " modules";
+    for (size_t m = 0; m < cached_modules_; ++m) {
+        key += ' ' + modules_[m]->getName();
+        keys[m] = key;
+    }
+
+    size_t number_of_cached = 0;
+    while (number_of_cached < cached_modules_ && result_cache_->read(keys[number_of_cached], entries[number_of_cached])
+            && entries[number_of_cached].size() == last - first) {
+        ++number_of_cached;
+    }
+    for (size_t m = number_of_cached; m < cached_modules_; ++m) {
+        entries[m].clear();
+    }
+
+    // timing statistics of this thread, if recorded
+    Instrumentation::ThreadStatistics* statistics = nullptr;
+    int64_t event_start = 0;
+    if (instrumentation_) {
+        statistics = &instrumentation_->local();
+        event_start = Instrumentation::now();
+    }
+
+    for (size_t i = first; i < last; ++i) {
+        Event e = createEvent(i);
+        size_t index = i - first;
+        batch_result.beginEvent(e.getNumber());
+
+        for (size_t m = 0; m < number_of_cached; ++m) {
+            const ResultCache::Entry& entry = entries[m];
+            batch_result.replay(entry.results.data() + entry.offsets[index],
+                static_cast<size_t>(entry.offsets[index + 1] - entry.offsets[index]));
+        }
+
+        // the stream of the event is only needed by the modules executed
+        if (number_of_cached < thread_modules.modules.size()) {
+            counting_engine.seed(e.getSeed());
+            if (number_of_cached > 0) {
+                counting_engine.skip(entries[number_of_cached - 1].draws[index]);
+            }
+        }
+
+        int64_t module_start = statistics ? Instrumentation::now() : 0;
+        for (size_t m = number_of_cached; m < thread_modules.modules.size(); ++m) {
+            Module* module = thread_modules.modules[m];
+            if (m < cached_modules_) {
+                recorded.clear();
+                module->run(e, &counting_engine, recorded);
+                entries[m].addEvent(counting_engine.getCount(), recorded.data(), recorded.size());
+                batch_result.replay(recorded.data(), recorded.size());
+            } else {
+                module->run(e, &counting_engine, batch_result);
+            }
+
+            if (statistics) {
+                int64_t module_end = Instrumentation::now();
+                statistics->recordModule(m, static_cast<uint64_t>(module_end - module_start));
+                module_start = module_end;
+            }
+        }
+        batch_result.endEvent();
+
+        if (statistics) {
+            int64_t event_end = Instrumentation::now();
+            statistics->event_time.record(static_cast<uint64_t>(event_end - event_start));
+            event_start = event_end;
+        }
+    }
+
+    for (size_t m = number_of_cached; m < cached_modules_; ++m) {
+        result_cache_->write(keys[m], entries[m]);
+    }
+    cached_results_ += number_of_cached * (last - first);
+    executed_results_ += (cached_modules_ - number_of_cached) * (last - first);
+}
+
+// Start the graph of the modules of the events of the batch in the slot of the
+// batch. The batch written last from the slot is done, only tasks of it that
+// didn't notice yet may still wait for the slot and are woken up to leave.
+void Simulation::prepareGraph(size_t batch)
+{
+    GraphBatch& graph = *graph_batches_[batch % graph_batches_.size()];
+    size_t first, last;
+    getBatchEvents(batch, first, last);
+    size_t number_of_modules = modules_.size();
+    size_t number_of_nodes = (last - first) * number_of_modules;
+
+    std::lock_guard<std::mutex> lock(graph.mutex);
+    graph.batch = batch;
+    graph.events.clear();
+    for (size_t i = first; i < last; ++i) {
+        graph.events.push_back(createEvent(i));
+    }
+
+    graph.results.resize(number_of_nodes);
+    for (OutputSink& result : graph.results) {
+        result.setFormat(OutputSink::Format::RECORDED);
+    }
+
+    // the ready nodes are taken from the back, the first event first
+    graph.waiting.resize(number_of_nodes);
+    graph.ready.clear();
+    for (size_t node = number_of_nodes; node-- > 0;) {
+        graph.waiting[node] = module_dependency_counts_[node % number_of_modules];
+        if (graph.waiting[node] == 0) {
+            graph.ready.push_back(node);
+        }
+    }
+    graph.remaining = number_of_nodes;
+    graph.nodes_ready.notify_all();
+}
+
+// Execute the modules of the events of the batch as their dependencies are
+// done. Every task of the batch takes the next ready module, so independent
+// modules of an event execute on several threads at once, and waits while the
+// modules left depend on modules still executing. Every module draws from
+// its own stream seeded by the seed of the event and the index of the module,
+// so the results don't depend on the thread executing it or on the order the
+// modules finish. The task finishing the last module appends the results of
+// every event in the order of the modules.
+void Simulation::runGraph(size_t batch)
+{
+    GraphBatch& graph = *graph_batches_[batch % graph_batches_.size()];
+    ThreadModules& thread_modules = getThreadModules();
+
+    // per thread random number generator of the configured type
+    static thread_local std::unique_ptr<RandomEngine> module_random_generator;
+    if (!module_random_generator || random_engine_name_ != module_random_generator->getName()) {
+        module_random_generator = RandomEngine::createRandomEngine(random_engine_name_);
+    }
+
+    // timing statistics of this thread, if recorded
+    Instrumentation::ThreadStatistics* statistics = nullptr;
+    int64_t task_start = 0;
+    if (instrumentation_) {
+        statistics = &instrumentation_->local();
+        task_start = Instrumentation::now();
+        statistics->queue_wait.record(static_cast<uint64_t>(
+            task_start - submit_times_[batch % submit_times_.size()]));
+    }
+
+    size_t number_of_modules = modules_.size();
+    bool finished_batch = false;
+    std::unique_lock<std::mutex> lock(graph.mutex);
+    while (!finished_batch) {
+        graph.nodes_ready.wait(lock, [&graph, batch]() {
+            return graph.batch != batch || graph.remaining == 0 || !graph.ready.empty();
+        });
+        if (graph.batch != batch || graph.remaining == 0) {
+            break;
+        }
+        size_t node = graph.ready.back();
+        graph.ready.pop_back();
+        lock.unlock();
+
+        size_t index = node / number_of_modules;
+        size_t m = node % number_of_modules;
+        const Event& e = graph.events[index];
+        int64_t module_start = statistics ? Instrumentation::now() : 0;
+        module_random_generator->seed(deriveSeed(e.getSeed(), static_cast<unsigned int>(m + 1)));
+        thread_modules.modules[m]->run(e, module_random_generator.get(), graph.results[node]);
+        if (statistics) {
+            statistics->recordModule(m, static_cast<uint64_t>(Instrumentation::now() - module_start));
+        }
+
+        lock.lock();
+        for (size_t dependent : module_dependents_[m]) {
+            size_t next = index * number_of_modules + dependent;
+            if (--graph.waiting[next] == 0) {
+                graph.ready.push_back(next);
+            }
+        }
+        finished_batch = (--graph.remaining == 0);
+        if (finished_batch || !module_dependents_[m].empty()) {
+            graph.nodes_ready.notify_all();
+        }
+    }
+    lock.unlock();
+
+    if (statistics) {
+        statistics->recordSpan("graph", batch, task_start, Instrumentation::now());
+    }
+    if (!finished_batch) {
+        return;
+    }
+
+    // the nodes are all done, their results are no longer written
+    static thread_local OutputSink batch_result;
+    batch_result.setFormat(output_format_, &output_modules_);
+    for (size_t index = 0; index < graph.events.size(); ++index) {
+        batch_result.beginEvent(graph.events[index].getNumber());
+        for (size_t m = 0; m < number_of_modules; ++m) {
+            const OutputSink& result = graph.results[index * number_of_modules + m];
+            batch_result.replay(result.data(), result.size());
+        }
+        batch_result.endEvent();
+    }
+
+    batch_result.finish();
+    if (output_format_ == OutputSink::Format::BINARY) {
+        block_sizes_[batch] = batch_result.size();
+    } else if (output_format_ == OutputSink::Format::SUMMARY) {
+        thread_modules.summary.merge(batch_result.getSummary());
+    }
+    writer_->write(batch, batch_result.data(), batch_result.size());
+}
+
+// Execute the modules of a stage of the pipeline on the events of the batch
+// held by the slot. The first stage starts the events with their seeds, every
+// event continues with its own random number engine in the following stages.
+void Simulation::runStage(size_t stage, size_t slot, size_t batch)
+{
+    PipelineSlot& events = pipeline_slots_[slot];
+    size_t first, last;
+    getBatchEvents(batch, first, last);
+
+    if (stage == 0) {
+        events.events.clear();
+        for (size_t i = first; i < last; ++i) {
+            events.events.push_back(createEvent(i));
+
+            size_t index = i - first;
+            events.random_engines[index]->seed(events.events.back().getSeed());
+            events.results[index].clear();
+            events.results[index].beginEvent(events.events.back().getNumber());
+        }
+    }
+
+    // timing statistics of this stage, if recorded
+    Instrumentation::ThreadStatistics* statistics = nullptr;
+    int64_t stage_start = 0;
+    if (instrumentation_) {
+        statistics = &instrumentation_->local();
+        stage_start = Instrumentation::now();
+    }
+
+    const std::vector<size_t>& modules = stages_[stage];
+    const std::vector<Module*>& thread_modules = getThreadModules().modules;
+    for (size_t index = 0; index < events.events.size(); ++index) {
+        const Event& e = events.events[index];
+        RandomEngine* random_engine = events.random_engines[index].get();
+        OutputSink& result = events.results[index];
+        if (statistics) {
+            int64_t module_start = Instrumentation::now();
+            for (size_t m : modules) {
+                thread_modules[m]->run(e, random_engine, result);
+                int64_t module_end = Instrumentation::now();
+                statistics->recordModule(m, static_cast<uint64_t>(module_end - module_start));
+                module_start = module_end;
+            }
+        } else {
+            for (size_t m : modules) {
+                thread_modules[m]->run(e, random_engine, result);
+            }
+        }
+    }
 
-    // print the results of the simulation to standard out
-    for (unsigned int i = 0; i < number_of_events_; ++i) {
-        std::cout << "event #" << i+1 << std::endl;
-        std::cout << simulation_results[i].get() << std::endl;
+    if (statistics) {
+        statistics->recordSpan("stage", batch, stage_start, Instrumentation::now());
     }
+
+    if (stage + 1 < stages_.size()) {
+        return;
+    }
+
+    // the results of the events follow each other in the results of the batch
+    OutputSink& batch_result = events.batch_result;
+    batch_result.clear();
+    for (size_t index = 0; index < events.events.size(); ++index) {
+        events.results[index].endEvent();
+        batch_result.appendEvents(events.results[index]);
+    }
+
+    batch_result.finish();
+    if (output_format_ == OutputSink::Format::BINARY) {
+        block_sizes_[batch] = batch_result.size();
+    } else if (output_format_ == OutputSink::Format::SUMMARY) {
+        getThreadModules().summary.merge(batch_result.getSummary());
+    }
+    writer_->write(batch, batch_result.data(), batch_result.size());
+}
+
+// Count a batch executed by the shared executor as done. The run may end as
+// soon as the lock is released, so nothing is touched afterwards.
+void Simulation::finishBatch()
+{
+    std::lock_guard<std::mutex> lock(batches_mutex_);
+    if (--pending_batches_ == 0) {
+        batches_done_.notify_all();
+    }
+}
+
+// Returns the modules of the calling thread for the current run. Threads keep
+// their modules from one batch to the next. Threads of a shared executor
+// alternate between the runs of several simulations and keep the modules of
+// the latest runs they executed.
+Simulation::ThreadModules& Simulation::getThreadModules()
+{
+    static thread_local std::vector<std::pair<uint64_t, ThreadModules*>> thread_runs;
+    for (const std::pair<uint64_t, ThreadModules*>& thread_run : thread_runs) {
+        if (thread_run.first == run_number_) {
+            return *thread_run.second;
+        }
+    }
+
+    std::unique_ptr<ThreadModules> thread_modules(new ThreadModules());
+#ifdef STATIC_PIPELINE_MODULES
+    if (use_compiled_pipeline_) {
+        thread_modules->modules = thread_modules->pipeline.getModules();
+    } else
+#endif
+    {
+        // the modules were loaded by these names, so creating them succeeds
+        std::vector<std::string> module_names = config_.getModuleNames();
+        for (const std::string& module_name : module_names) {
+            std::shared_ptr<Module> module;
+            if (module_cache_) {
+                module = module_cache_->acquire(module_name, ModuleCache::Use::THREAD);
+            }
+            if (!module) {
+                module = Module::createModule(module_name);
+            }
+            thread_modules->instances.push_back(module);
+            thread_modules->modules.push_back(module.get());
+        }
+    }
+
+    for (size_t m = 0; m < modules_.size(); ++m) {
+        thread_modules->modules[m]->initializeThread(*modules_[m]);
+    }
+
+    // a thread executing more runs at once creates the modules of the
+    // oldest run again if it comes back to it
+    if (thread_runs.size() == MAX_RUNS_PER_THREAD) {
+        thread_runs.erase(thread_runs.begin());
+    }
+    thread_runs.emplace_back(run_number_, thread_modules.get());
+
+    std::lock_guard<std::mutex> lock(thread_modules_mutex_);
+    thread_modules_.push_back(std::move(thread_modules));
+    return *thread_modules_.back();
+}
+
+// Merge the modules of all threads into the loaded modules and finalize the
+// run. All events are executed, so the threads don't use their modules
+// anymore and they are kept for the following runs if there is a cache.
+void Simulation::finalizeModules()
+{
+    std::vector<std::string> module_names = config_.getModuleNames();
+    std::lock_guard<std::mutex> lock(thread_modules_mutex_);
+
+    // the summaries of the threads are reduced into the summary of the run
+    summary_.clear();
+    if (output_format_ == OutputSink::Format::SUMMARY && !thread_modules_.empty()) {
+        std::vector<Summary*> summaries;
+        for (const std::unique_ptr<ThreadModules>& thread_modules : thread_modules_) {
+            summaries.push_back(&thread_modules->summary);
+        }
+        Summary::reduce(summaries);
+        summary_.merge(*summaries.front());
+    }
+
+    for (const std::unique_ptr<ThreadModules>& thread_modules : thread_modules_) {
+        for (size_t m = 0; m < modules_.size(); ++m) {
+            thread_modules->modules[m]->finalizeThread();
+            modules_[m]->merge(*thread_modules->modules[m]);
+        }
+
+        if (module_cache_) {
+            for (size_t m = 0; m < thread_modules->instances.size(); ++m) {
+                module_cache_->release(module_names[m], ModuleCache::Use::THREAD,
+                    std::move(thread_modules->instances[m]));
+            }
+        }
+    }
+    thread_modules_.clear();
+
+    for (const std::shared_ptr<Module>& module : modules_) {
+        module->finalize();
+    }
+}
+
+// Choose the number of workers from the time the first events took on the
+// main thread. Workers only pay off once each of them gets enough work to
+// amortize starting it, so short simulations stay on the main thread and
+// long ones use all available CPUs. The executor keeps tuning the number
+// from there.
+size_t Simulation::chooseNumberOfWorkers(int64_t warm_up_time, size_t warm_up_events) const
+{
+    double time_per_event = static_cast<double>(warm_up_time) / std::max<size_t>(1, warm_up_events);
+    double remaining_time = time_per_event * (number_of_events_ - warm_up_events);
+    size_t number_of_workers = std::min<size_t>(number_of_threads_,
+        static_cast<size_t>(remaining_time / MIN_WORK_PER_WORKER));
+
+    // a single worker would only take turns with the main thread
+    return number_of_workers >= 2 ? number_of_workers : 0;
+}
+
+// Choose the number of events executed by each task. Unless specified in the
+// configuration, aim for enough tasks per thread to balance the load while
+// amortizing the per task overhead over as many events as possible.
+size_t Simulation::chooseGrainSize() const
+{
+    size_t grain_size = config_.getGrainSize();
+    if (grain_size == 0 && result_cache_) {
+        // the entries of the result cache hold the results of a batch, so
+        // the batches of the following runs must be the same. They are
+        // aligned to the event numbers, see getBatchEvents.
+        grain_size = MAX_GRAIN_SIZE;
+    } else if (grain_size == 0) {
+        size_t number_of_tasks = std::max<size_t>(1, number_of_threads_) * TASKS_PER_THREAD;
+        grain_size = std::min<size_t>(MAX_GRAIN_SIZE, number_of_events_ / number_of_tasks);
+    }
+
+    return std::max<size_t>(1, grain_size);
+}
+
+// Get the events of the batch. With the result cache the batches are aligned
+// to the grain size in event numbers and the first batch only runs up to the
+// next boundary, otherwise every batch but the last is a full grain.
+void Simulation::getBatchEvents(size_t batch, size_t& first, size_t& last) const
+{
+    first = (batch == 0) ? 0 : batch * grain_size_ - batch_offset_;
+    last = std::min<size_t>((batch + 1) * grain_size_ - batch_offset_, number_of_events_);
+}
+
+// Write data to the stream if any or to the file descriptor.
+bool Simulation::writeOutput(std::ostream* stream, int fd, const std::string& data)
+{
+    if (stream) {
+        stream->write(data.data(), data.size());
+        return !stream->fail();
+    }
+
+    return OrderedWriter::writeFully(fd, data.data(), data.size());
+}
+
+// Save the progress of the run to the checkpoint file if the events written
+// reached the next checkpoint or if forced. The output is synced first so
+// the checkpoint never covers results that could still be lost.
+void Simulation::saveCheckpoint(size_t batches_written, uint64_t output_offset, bool force)
+{
+    size_t events_written = 0;
+    if (batches_written > 0) {
+        size_t first;
+        getBatchEvents(batches_written - 1, first, events_written);
+    }
+    unsigned int next_event = static_cast<unsigned int>(first_event_ + events_written);
+    if (!force && next_event < next_checkpoint_event_) {
+        return;
+    }
+    next_checkpoint_event_ = next_event + config_.getCheckpointInterval();
+
+    fdatasync(output_fd_);
+    checkpoint_->setProgress(next_event, output_offset);
+    if (!checkpoint_->write(config_.getCheckpointFile())) {
+        std::cerr << "ERROR: Couldn't write checkpoint " << config_.getCheckpointFile() << std::endl;
+    }
+}
+
+// Returns the index of the blocks of a binary result file and its footer.
+// The blocks of this run follow the given offset in batch order, after the
+// blocks written before the checkpoint when resuming.
+std::string Simulation::encodeIndex(uint64_t offset) const
+{
+    std::string index = resumed_index_;
+    for (size_t batch = 0; batch < block_sizes_.size(); ++batch) {
+        size_t first, last;
+        getBatchEvents(batch, first, last);
+        BinaryFormat::IndexEntry entry {
+            static_cast<uint32_t>(first_event_ + first),
+            static_cast<uint32_t>(last - first),
+            offset
+        };
+        index.append(reinterpret_cast<const char*>(&entry), sizeof(entry));
+        offset += block_sizes_[batch];
+    }
+
+    size_t number_of_blocks = index.size() / sizeof(BinaryFormat::IndexEntry);
+    BinaryFormat::Footer footer {offset, number_of_blocks, BinaryFormat::FOOTER_MAGIC, BinaryFormat::VERSION};
+    index.append(reinterpret_cast<const char*>(&footer), sizeof(footer));
+
+    return index;
+}
+
+// Derive the seed of an event from the initial seed and the event number.
+// The pair is scrambled by the SplitMix64 mixing function, so seeds of
+// consecutive events are unrelated while the same pair always gives the
+// same seed.
+unsigned int Simulation::deriveSeed(unsigned int initial_seed, unsigned int number)
+{
+    uint64_t state = (static_cast<uint64_t>(initial_seed) << 32) | number;
+    return static_cast<unsigned int>(SplitMix64Engine::next(state) >> 32);
 }
@@ -2,9 +2,26 @@
 
 #include "module.hpp"
 #include "configuration.hpp"
+#include "event.hpp"
+#include "executor.hpp"
+#include "outputSink.hpp"
+#include "summary.hpp"
 
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <iosfwd>
 #include <random>
 #include <vector>
+#include <memory>
+#include <mutex>
+
+class Checkpoint;
+class InputFile;
+class Instrumentation;
+class ModuleCache;
+class OrderedWriter;
+class ResultCache;
 
 // The main simulation engine in the framework. Controlls the modules
 // and the execution of all simulation events.
@@ -12,24 +29,354 @@ class Simulation
 {
 public:
     explicit Simulation(const Configuration& config);
+    ~Simulation();
 
     // Initialize the simulation modules.
     bool init();
 
-    // Run the simulation using the specified number of events.
-    void run();
+    // Run the simulation using the specified number of events. Results are
+    // written to the output file of the configuration or to standard out.
+    // returns: false if the results couldn't be written.
+    bool run();
+
+    // Run the simulation writing the event results to the given stream.
+    // returns: false if the results couldn't be written.
+    bool run(std::ostream& output);
+
+    // Run the simulation writing the event results to the given file
+    // descriptor, e.g. the connection of a client, instead of standard out.
+    // An output file of the configuration is still used.
+    // returns: false if the results couldn't be written.
+    bool run(int fd);
+
+    // Resume the simulation from the checkpoint of an earlier run that was
+    // interrupted, if there is one. Must be called before init.
+    void setResume(bool resume) {
+        resume_ = resume;
+    }
+
+    // Execute the events of the following runs on an executor shared with
+    // other simulations running at the same time, e.g. a SharedExecutor,
+    // instead of an executor of their own. The runs wait for their own
+    // events and leave finishing the executor to its owner. The placement
+    // of the workers belongs to the executor, so the worker affinity of the
+    // configuration is ignored. Must be called before init.
+    void setExecutor(Executor* executor) {
+        shared_executor_ = executor;
+    }
+
+    // Take the modules from the given cache and return them to it once the
+    // simulation no longer uses them, or create new modules if null. Must
+    // be called before init.
+    void setModuleCache(ModuleCache* module_cache) {
+        module_cache_ = module_cache;
+    }
+
+    // Record timing statistics of the following runs into the given
+    // instrumentation, or stop recording them if null.
+    void setInstrumentation(Instrumentation* instrumentation) {
+        instrumentation_ = instrumentation;
+    }
 
 private:
+    // Run the simulation writing the event results to the stream if any or
+    // to the file descriptor.
+    // returns: false if the results couldn't be written.
+    bool run(std::ostream* stream, int fd);
+
+    // Instances of the modules executing the events of a run on one thread.
+    struct ThreadModules;
+
+    // Execute the events of the given batch and hand their results to the writer.
+    void runBatch(size_t batch);
+
+    // Returns the event with the given index in the run.
+    Event createEvent(size_t i) const;
+
+    // Execute the events from first to last of a batch in blocks, appending
+    // their results to the batch result.
+    void runBlocks(size_t first, size_t last, ThreadModules& thread_modules, OutputSink& batch_result);
+
+    // Execute the events from first to last of a batch taking the results
+    // of the longest prefix of the modules found in the result cache, and
+    // keep the results of the cached modules executed in the cache.
+    void runCachedEvents(size_t first, size_t last, ThreadModules& thread_modules,
+        RandomEngine& random_engine, OutputSink& batch_result);
+
+    // Start the graph of the modules of the events of the given batch before
+    // submitting the tasks executing it.
+    void prepareGraph(size_t batch);
+
+    // Execute the modules of the events of the given batch that are ready,
+    // sharing them with the other tasks of the batch. The task executing the
+    // last module hands the results to the writer.
+    void runGraph(size_t batch);
+
+    // Execute the modules of a stage of the pipeline on the events of the
+    // batch held by the slot. The last stage hands the results to the writer.
+    void runStage(size_t stage, size_t slot, size_t batch);
+
+    // Returns the modules of the calling thread for the current run. They
+    // are created and initialized when the thread executes its first events.
+    ThreadModules& getThreadModules();
+
+    // Merge the modules of all threads into the loaded modules and finalize
+    // the run.
+    void finalizeModules();
+
+    // Count a batch executed by the shared executor as done.
+    void finishBatch();
+
+    // Choose the number of workers given the time in nanoseconds the first
+    // events took on the main thread.
+    size_t chooseNumberOfWorkers(int64_t warm_up_time, size_t warm_up_events) const;
+
+    // Choose the number of events executed by each task.
+    size_t chooseGrainSize() const;
+
+    // Get the events of the batch, relative to the first event of the run.
+    void getBatchEvents(size_t batch, size_t& first, size_t& last) const;
+
+    // Group the modules into the stages of the pipeline.
+    void chooseStages();
+
+    // Choose the CPUs the workers are pinned to from the worker affinity of
+    // the configuration.
+    bool chooseWorkerPlacement();
+
+    // Open the output file of the configuration, truncated to the output
+    // of the events before the checkpoint when resuming.
+    bool openOutputFile();
+
+    // Read the index entries of the blocks in the output file before the
+    // checkpoint when resuming a binary run.
+    bool readResumedIndex(uint64_t header_size, uint64_t output_offset);
+
+    // Save the progress of the run given the number of batches written and
+    // the size of the output file, if a checkpoint is due or forced.
+    void saveCheckpoint(size_t batches_written, uint64_t output_offset, bool force);
+
+    // Returns the index of the blocks of a binary result file and its footer.
+    std::string encodeIndex(uint64_t offset) const;
+
+    // Write data to the stream if any or to the file descriptor.
+    // returns: false if writing to the file descriptor failed.
+    static bool writeOutput(std::ostream* stream, int fd, const std::string& data);
+
+    // Derive the seed of an event from the initial seed and the event number.
+    static unsigned int deriveSeed(unsigned int initial_seed, unsigned int number);
+
+    // default number of events waiting for execution per worker thread
+    static constexpr size_t PENDING_EVENTS_PER_THREAD = 64;
+
+    // minimum number of event results held in memory waiting to be written
+    static constexpr size_t MIN_OUTPUT_WINDOW = 1024;
+
+    // number of event results held in memory per worker thread
+    static constexpr size_t OUTPUT_WINDOW_PER_THREAD = 256;
+
+    // number of tasks per thread the automatic grain size aims for
+    static constexpr size_t TASKS_PER_THREAD = 16;
+
+    // maximum number of events executed by each task when tuned automatically
+    static constexpr size_t MAX_GRAIN_SIZE = 256;
+
+    // number of runs a thread keeps its modules for, threads executing the
+    // events of more simulations at once create them again
+    static constexpr size_t MAX_RUNS_PER_THREAD = 8;
+
+    // number of batches in flight per stage of the pipeline
+    static constexpr size_t SLOTS_PER_STAGE = 2;
+
+    // nanoseconds of work each worker needs to pay off its start when the
+    // number of threads is chosen automatically
+    static constexpr double MIN_WORK_PER_WORKER = 1e6;
+
     // reference to the configuration file.
     const Configuration& config_;
 
     // list of loaded modules in the simulation
     std::vector<std::shared_ptr<Module>> modules_;
 
-    // total number of events in the simulation
+    // instances of the modules of every thread executing events in the
+    // current run, in the order the threads started
+    std::vector<std::unique_ptr<ThreadModules>> thread_modules_;
+    std::mutex thread_modules_mutex_;
+
+    // number of the current run, unique in the process so threads can tell
+    // their modules belong to an earlier run
+    uint64_t run_number_ {0};
+
+    // whether the loaded modules match the modules compiled into a static
+    // pipeline, which then executes them instead of the virtual calls
+    bool use_compiled_pipeline_ {false};
+
+    // whether the modules execute blocks of events, each module executing
+    // all events of a block before the next module
+    bool use_event_blocks_ {false};
+
+    // Batch of events in flight in the pipeline. The events carry their
+    // random number engine and results from one stage to the next, so the
+    // modules draw the same numbers as when the event runs on one thread.
+    struct PipelineSlot {
+        std::vector<Event> events;
+        std::vector<std::unique_ptr<RandomEngine>> random_engines;
+        std::vector<OutputSink> results;
+
+        // results of all events of the batch handed to the writer
+        OutputSink batch_result;
+    };
+
+    // indices of the modules executed by each stage of the pipeline, empty
+    // unless the modules are executed as a pipeline
+    std::vector<std::vector<size_t>> stages_;
+
+    // batches in flight in the pipeline
+    std::vector<PipelineSlot> pipeline_slots_;
+
+    // Batch of events executed as a graph of modules by several tasks. Node
+    // index * number of modules + m is module m of event index of the batch.
+    // The state is shared by the tasks and protected by the mutex, only the
+    // results of a node are written by the task executing it.
+    struct GraphBatch {
+        std::mutex mutex;
+        std::condition_variable nodes_ready;
+
+        // number of the batch held, tasks of an earlier batch using the
+        // slot find it taken
+        size_t batch {SIZE_MAX};
+        std::vector<Event> events;
+
+        // nodes whose dependencies are done and that no task took yet
+        std::vector<size_t> ready;
+
+        // number of dependencies of every node that are not done yet
+        std::vector<size_t> waiting;
+
+        // number of nodes not done yet
+        size_t remaining {0};
+
+        // results of every node recorded to be appended in module order
+        std::vector<OutputSink> results;
+    };
+
+    // indices of the modules depending on every module and number of
+    // modules every module depends on, when executing the graph of the
+    // modules
+    std::vector<std::vector<size_t>> module_dependents_;
+    std::vector<size_t> module_dependency_counts_;
+
+    // largest number of modules of an event that may execute at once, the
+    // number at the same depth of the graph
+    size_t graph_width_ {1};
+
+    // batches in flight executed as graphs, indexed by batch modulo size
+    std::vector<std::unique_ptr<GraphBatch>> graph_batches_;
+
+    // executor shared with other simulations, or null if every run creates
+    // an executor of its own
+    Executor* shared_executor_ {nullptr};
+
+    // number of batches submitted to the shared executor and not yet done
+    size_t pending_batches_ {0};
+    std::mutex batches_mutex_;
+    std::condition_variable batches_done_;
+
+    // cache the modules are taken from and returned to, if any
+    ModuleCache* module_cache_ {nullptr};
+
+    // number of worker threads, the most available with an automatic number
+    size_t number_of_threads_ {0};
+
+    // number of the first event to execute
+    unsigned int first_event_ {1};
+
+    // total number of events to execute
     unsigned int number_of_events_ {0};
 
+    // number of consecutive events executed by each task
+    size_t grain_size_ {1};
+
+    // number of events the first batch is short of the grain size, so the
+    // batches of the result cache start at the same event numbers whatever
+    // the first event of the run
+    size_t batch_offset_ {0};
+
+    // seeds of the events in flight drawn in sequence from the main
+    // generator, indexed by event index modulo size.
+    // The output window bounds the events in flight so slots are reused
+    // only after the event using them is written.
+    std::vector<unsigned int> event_seeds_;
+
+    // records of the events, if the configuration has an input file
+    std::unique_ptr<InputFile> input_;
+
+    // results of the modules kept for the following runs, if configured
+    std::unique_ptr<ResultCache> result_cache_;
+
+    // number of leading modules supporting the result cache, the results
+    // of the modules after them aren't kept
+    size_t cached_modules_ {0};
+
+    // start of the keys of all results in the result cache, naming what the
+    // results depend on besides the events and the modules
+    std::string result_cache_key_;
+
+    // number of results of the cached modules for an event taken from the
+    // result cache and executed in the current run
+    std::atomic<uint64_t> cached_results_ {0};
+    std::atomic<uint64_t> executed_results_ {0};
+
+    // format of the results
+    OutputSink::Format output_format_ {OutputSink::Format::TEXT};
+
+    // aggregates of the values of all events of the run, when only the
+    // summary is written
+    Summary summary_;
+
+    // distinct names of the loaded modules, referred to by binary results
+    std::vector<std::string> output_modules_;
+
+    // size of the encoded block of every batch of a binary run, from which
+    // the index of the file is built
+    std::vector<uint64_t> block_sizes_;
+
+    // placement of the workers on the CPUs of the machine
+    Executor::Placement placement_;
+
+    // file descriptor of the output file of the configuration, if any
+    int output_fd_ {-1};
+
+    // whether to resume from the checkpoint of an earlier run
+    bool resume_ {false};
+
+    // progress of the simulation saved to the checkpoint file, if any
+    std::unique_ptr<Checkpoint> checkpoint_;
+
+    // number of the event after which the next checkpoint is due
+    unsigned int next_checkpoint_event_ {0};
+
+    // size of the output file before the results of this run
+    uint64_t output_offset_ {0};
+
+    // index entries of the blocks written before the checkpoint when
+    // resuming a binary run
+    std::string resumed_index_;
+
+    // streaming output stage of the current run
+    std::unique_ptr<OrderedWriter> writer_;
+
+    // timing statistics of the runs, or null if they are not recorded
+    Instrumentation* instrumentation_ {nullptr};
+
+    // time in nanoseconds each batch in flight was submitted at, indexed by
+    // batch modulo size. Only used when recording timing statistics.
+    std::vector<int64_t> submit_times_;
+
+    // name of the random number engine used by the events
+    std::string random_engine_name_;
+
     // mersenne twister pseudo-random number generator.
-    // this is the core generator of the simulator.
+    // this is the core generator of the simulator drawing the event seeds.
 	std::mt19937 random_engine_;
 };
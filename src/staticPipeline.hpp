@@ -0,0 +1,62 @@
+#pragma once
+
+#include "outputSink.hpp"
+
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+class Event;
+class Module;
+
+// Compile time chain of modules for builds where the list of modules is
+// fixed. The modules are held by value and their non virtual process method
+// is called in order, so the compiler can inline the whole chain in the
+// event loop instead of making a virtual call per module per event.
+//
+// Module classes used in a pipeline must provide
+//     template <typename Engine>
+//     void process(const Event&, Engine&, OutputSink&);
+// which does the same as their run method.
+template <typename... Modules>
+class StaticPipeline
+{
+public:
+    // Execute all modules of the pipeline for the given event.
+    template <typename Engine>
+    void run(const Event& e, Engine& random_engine, OutputSink& output) {
+        run(e, random_engine, output, std::index_sequence_for<Modules...>());
+    }
+
+    // Returns the names of the modules in pipeline order.
+    std::vector<std::string> getModuleNames() const {
+        return getModuleNames(std::index_sequence_for<Modules...>());
+    }
+
+    // Returns the modules of the pipeline in order, e.g. to call their hooks.
+    std::vector<Module*> getModules() {
+        return getModules(std::index_sequence_for<Modules...>());
+    }
+
+private:
+    template <typename Engine, size_t... I>
+    void run(const Event& e, Engine& random_engine, OutputSink& output, std::index_sequence<I...>) {
+        // expands to one call per module, evaluated in order
+        int expand[] = {0, (std::get<I>(modules_).process(e, random_engine, output), 0)...};
+        (void)expand;
+    }
+
+    template <size_t... I>
+    std::vector<std::string> getModuleNames(std::index_sequence<I...>) const {
+        return {std::get<I>(modules_).getName()...};
+    }
+
+    template <size_t... I>
+    std::vector<Module*> getModules(std::index_sequence<I...>) {
+        return {&std::get<I>(modules_)...};
+    }
+
+    // modules of the pipeline in order
+    std::tuple<Modules...> modules_;
+};
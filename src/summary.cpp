@@ -0,0 +1,104 @@
+#include "summary.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+void Summary::Statistics::merge(const Statistics& other)
+{
+    count += other.count;
+    min = other.min < min ? other.min : min;
+    max = other.max > max ? other.max : max;
+    sum.add(other.sum);
+    sum_of_squares.add(other.sum_of_squares);
+    for (size_t bin = 0; bin < HISTOGRAM_BINS; ++bin) {
+        histogram[bin] += other.histogram[bin];
+    }
+}
+
+// Add the aggregates of another summary.
+void Summary::merge(const Summary& other)
+{
+    number_of_events_ += other.number_of_events_;
+    for (size_t module = 0; module < other.modules_.size(); ++module) {
+        const std::vector<Statistics>& positions = other.modules_[module];
+        if (positions.empty()) {
+            continue;
+        }
+        if (module >= modules_.size() || positions.size() > modules_[module].size()) {
+            resize(module, positions.size());
+        }
+        for (size_t i = 0; i < positions.size(); ++i) {
+            modules_[module][i].merge(positions[i]);
+        }
+    }
+}
+
+// Merge the summaries pairwise into the first one. Each level halves the
+// number of summaries, so every summary is merged at most log2(n) times.
+void Summary::reduce(const std::vector<Summary*>& summaries)
+{
+    for (size_t stride = 1; stride < summaries.size(); stride *= 2) {
+        for (size_t i = 0; i + stride < summaries.size(); i += 2 * stride) {
+            summaries[i]->merge(*summaries[i + stride]);
+        }
+    }
+}
+
+// Remove all aggregates, keeping the modules and value positions seen so
+// far so that adding values doesn't allocate again.
+void Summary::clear()
+{
+    number_of_events_ = 0;
+    for (std::vector<Statistics>& positions : modules_) {
+        for (Statistics& statistics : positions) {
+            statistics = Statistics();
+        }
+    }
+}
+
+// Make room for the values of a module.
+void Summary::resize(size_t module, size_t count)
+{
+    if (module >= modules_.size()) {
+        modules_.resize(module + 1);
+    }
+    if (count > modules_[module].size()) {
+        modules_[module].resize(count);
+    }
+}
+
+// Returns the text of the summary. Every value position is a line of its
+// aggregates followed by its histogram, e.g.
+//   Module1_1 count 1000 min 4190 max 4292961327 mean 2136488134.377 stddev 1241337234.560
+//   Module1_1 histogram 61 58 ...
+std::string Summary::format(const std::vector<std::string>& module_names) const
+{
+    std::string text = "summary of " + std::to_string(number_of_events_) + " events\n";
+    for (size_t module = 0; module < modules_.size() && module < module_names.size(); ++module) {
+        for (size_t i = 0; i < modules_[module].size(); ++i) {
+            const Statistics& statistics = modules_[module][i];
+            if (statistics.count == 0) {
+                continue;
+            }
+
+            long double count = static_cast<long double>(statistics.count);
+            long double mean = statistics.sum.get() / count;
+            long double variance = statistics.sum_of_squares.get() / count - mean * mean;
+            char moments[64];
+            std::snprintf(moments, sizeof(moments), " mean %.3Lf stddev %.3Lf",
+                mean, std::sqrt(std::max(variance, 0.0L)));
+
+            std::string name = module_names[module] + '_' + std::to_string(i + 1);
+            text += name + " count " + std::to_string(statistics.count)
+                + " min " + std::to_string(statistics.min)
+                + " max " + std::to_string(statistics.max) + moments + '\n';
+            text += name + " histogram";
+            for (size_t bin = 0; bin < HISTOGRAM_BINS; ++bin) {
+                text += ' ' + std::to_string(statistics.histogram[bin]);
+            }
+            text += '\n';
+        }
+    }
+    return text;
+}
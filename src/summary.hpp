@@ -0,0 +1,111 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Aggregates of the values the modules append to the results of the events,
+// kept instead of the results themselves when only the summary of a run is
+// written. Every value position of the records of a module, e.g. the first
+// and the second number drawn by Module1, gets the count, minimum, maximum,
+// sum and sum of squares of its values and a histogram of them.
+//
+// All aggregates are integers, the sums are kept in 128 bits so they can't
+// overflow, which makes merging summaries exact and independent of the
+// order. The summary of a run is the same however its events were split
+// between the threads.
+class Summary
+{
+public:
+    // number of bins of the histograms, each covering an equal range of the
+    // 32 bit values
+    static constexpr size_t HISTOGRAM_BINS = 16;
+
+    // Unsigned 128 bit integer holding a sum.
+    struct Sum {
+        uint64_t low {0};
+        uint64_t high {0};
+
+        void add(uint64_t value) {
+            low += value;
+            high += (low < value);
+        }
+
+        void add(const Sum& other) {
+            add(other.low);
+            high += other.high;
+        }
+
+        // Returns the sum as a floating point number.
+        long double get() const {
+            return static_cast<long double>(high) * 18446744073709551616.0L + low;
+        }
+    };
+
+    // Aggregates of the values at one position of the records of a module.
+    struct Statistics {
+        uint64_t count {0};
+        uint32_t min {UINT32_MAX};
+        uint32_t max {0};
+        Sum sum;
+        Sum sum_of_squares;
+        uint64_t histogram[HISTOGRAM_BINS] {};
+
+        void add(uint32_t value) {
+            ++count;
+            min = value < min ? value : min;
+            max = value > max ? value : max;
+            sum.add(value);
+            sum_of_squares.add(static_cast<uint64_t>(value) * value);
+            ++histogram[value >> 28];
+        }
+
+        void merge(const Statistics& other);
+    };
+
+    // Count an event.
+    void addEvent() {
+        ++number_of_events_;
+    }
+
+    // Add the values of a record of the module with the given index.
+    void addValues(size_t module, const uint32_t* values, size_t count) {
+        if (module >= modules_.size() || count > modules_[module].size()) {
+            resize(module, count);
+        }
+        std::vector<Statistics>& positions = modules_[module];
+        for (size_t i = 0; i < count; ++i) {
+            positions[i].add(values[i]);
+        }
+    }
+
+    // Add the aggregates of another summary.
+    void merge(const Summary& other);
+
+    // Merge the summaries pairwise, level by level of a binary tree, into
+    // the first one.
+    static void reduce(const std::vector<Summary*>& summaries);
+
+    // Remove all aggregates.
+    void clear();
+
+    // Returns the number of events counted.
+    uint64_t getNumberOfEvents() const {
+        return number_of_events_;
+    }
+
+    // Returns the text of the summary, the modules are referred to by their
+    // index in the given names.
+    std::string format(const std::vector<std::string>& module_names) const;
+
+private:
+    // Make room for the values of a module.
+    void resize(size_t module, size_t count);
+
+    // number of events counted
+    uint64_t number_of_events_ {0};
+
+    // aggregates of every value position of every module
+    std::vector<std::vector<Statistics>> modules_;
+};
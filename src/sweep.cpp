@@ -0,0 +1,168 @@
+#include "sweep.hpp"
+#include "configuration.hpp"
+#include "cpuTopology.hpp"
+#include "executor.hpp"
+#include "instrumentation.hpp"
+#include "sharedExecutor.hpp"
+#include "simulation.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <thread>
+
+// Read a sweep file.
+std::unique_ptr<Sweep> Sweep::createSweep(const std::string& path)
+{
+    std::ifstream sweep_file(path);
+    if (!sweep_file) {
+        std::cerr << "ERROR: Couldn't open sweep file " << path << '\n';
+        return nullptr;
+    }
+
+    std::unique_ptr<Sweep> sweep(new Sweep());
+
+    // read the file line by line expecting a key-value pair on each line.
+    std::string line;
+    while (getline(sweep_file, line)) {
+        if (line.empty()) {
+            continue;
+        }
+
+        std::stringstream tokenizer(line);
+        std::string key, equal_sign, value;
+        tokenizer >> key >> equal_sign >> value;
+        if (equal_sign != "=" || value.empty()) {
+            std::cerr << "ERROR: Unexpected token " << equal_sign << '\n';
+            return nullptr;
+        }
+
+        char* end;
+        if (key == "run") {
+            sweep->runs_.push_back(value);
+        } else if (key == "number_of_threads") {
+            sweep->automatic_threads_ = (value == "auto");
+            if (!sweep->automatic_threads_) {
+                sweep->number_of_threads_ = static_cast<unsigned int>(std::strtoul(value.c_str(), &end, 10));
+                if (*end != '\0') {
+                    std::cerr << "ERROR: Invalid numeric value\n";
+                    return nullptr;
+                }
+            }
+        } else if (key == "scheduler") {
+            if (value != "shared_queue" && value != "work_stealing") {
+                std::cerr << "ERROR: Unknown scheduler " << value << '\n';
+                return nullptr;
+            }
+            sweep->scheduler_ = value;
+        } else if (key == "concurrent_runs") {
+            sweep->concurrent_runs_ = static_cast<unsigned int>(std::strtoul(value.c_str(), &end, 10));
+            if (*end != '\0') {
+                std::cerr << "ERROR: Invalid numeric value\n";
+                return nullptr;
+            }
+        }
+    }
+
+    if (sweep->runs_.empty()) {
+        std::cerr << "ERROR: Sweep file " << path << " has no runs\n";
+        return nullptr;
+    }
+
+    return sweep;
+}
+
+// Run all simulations of the sweep. Every thread running simulations takes
+// the next one of the sweep until all are done, the simulations submit
+// their events to the same executor.
+bool Sweep::run()
+{
+    size_t number_of_workers = automatic_threads_ ? CpuTopology::getAvailableCpus() : number_of_threads_;
+    SharedExecutor executor(Executor::createExecutor(scheduler_, number_of_workers,
+        number_of_workers * PENDING_TASKS_PER_WORKER));
+    if (automatic_threads_) {
+        executor.setActiveWorkers(number_of_workers, true);
+    }
+
+    // a simulation starting while another one is finishing keeps the
+    // workers busy
+    size_t concurrent_runs = concurrent_runs_ > 0 ? concurrent_runs_ : std::max<size_t>(2, number_of_workers);
+    concurrent_runs = std::min(concurrent_runs, runs_.size());
+
+    std::atomic<size_t> next_run {0};
+    std::atomic<bool> succeeded {true};
+    auto run_simulations = [this, &executor, &next_run, &succeeded]() {
+        for (size_t run = next_run++; run < runs_.size(); run = next_run++) {
+            if (!runSimulation(runs_[run], executor)) {
+                succeeded = false;
+            }
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (size_t i = 1; i < concurrent_runs; ++i) {
+        threads.push_back(std::thread(run_simulations));
+    }
+    run_simulations();
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+
+    executor.execute();
+    return succeeded;
+}
+
+// Run the simulation of the given configuration file on the executor.
+bool Sweep::runSimulation(const std::string& config_path, Executor& executor)
+{
+    Configuration config = Configuration::createConfiguration(config_path);
+    if (!config.correct()) {
+        std::cerr << "ERROR: Incorrect configuration file " << config_path << '\n';
+        return false;
+    }
+
+    // every simulation gets an output file of its own
+    if (config.getOutputFile().empty()) {
+        config.setOutputFile(config_path + ".out");
+    }
+
+    Simulation simulation(config);
+    simulation.setResume(resume_);
+    simulation.setExecutor(&executor);
+    simulation.setModuleCache(&module_cache_);
+    if (!simulation.init()) {
+        std::cerr << "ERROR: Couldn't initialize simulation " << config_path << '\n';
+        return false;
+    }
+
+    // optionally record timing statistics of the simulation
+    Instrumentation instrumentation(!config.getTraceFile().empty());
+    if (config.useInstrumentation()) {
+        simulation.setInstrumentation(&instrumentation);
+    }
+
+    // a run whose results weren't all written keeps its last checkpoint, so
+    // resuming the sweep runs it again
+    bool succeeded = simulation.run();
+    if (!succeeded) {
+        std::cerr << "ERROR: Couldn't write the results of simulation " << config_path << '\n';
+    }
+
+    if (config.useInstrumentation()) {
+        std::lock_guard<std::mutex> lock(report_mutex_);
+        std::cout << "INFO: Statistics of " << config_path << '\n';
+        instrumentation.report(std::cout, config.getModuleNames());
+    }
+    if (!config.getTraceFile().empty()) {
+        std::ofstream trace_file(config.getTraceFile());
+        instrumentation.writeTrace(trace_file);
+        if (!trace_file) {
+            std::cerr << "ERROR: Couldn't write trace file " << config.getTraceFile() << '\n';
+        }
+    }
+
+    return succeeded;
+}
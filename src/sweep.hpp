@@ -0,0 +1,84 @@
+#pragma once
+
+#include "moduleCache.hpp"
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+class Executor;
+
+// Runs many simulations in one process, e.g. the simulations of a parameter
+// sweep differing in seed, number of events or modules. The simulations
+// share one executor whose workers are started once, and the instances of
+// their modules are kept for the following simulations. Several simulations
+// run at the same time, so the workers execute the events of one while
+// another one starts or waits for its last events.
+//
+// A sweep file holds key value pairs like a configuration file:
+//     run = path/to/simulation.conf    a simulation of the sweep, repeated
+//                                      for every simulation
+//     number_of_threads = 8            optional number of workers, by default
+//                                      auto for all available CPUs
+//     scheduler = work_stealing        optional scheduler of the workers
+//     concurrent_runs = 4              optional number of simulations running
+//                                      at the same time
+class Sweep
+{
+public:
+    // Factory method for reading sweep files.
+    // params: path - The path of the sweep file.
+    // returns: pointer to the sweep or null if the file is not correct.
+    static std::unique_ptr<Sweep> createSweep(const std::string& path);
+
+    // Resume the simulations from the checkpoints of an earlier sweep that
+    // was interrupted, if they have one.
+    void setResume(bool resume) {
+        resume_ = resume;
+    }
+
+    // Returns the number of simulations of the sweep.
+    size_t getNumberOfRuns() const {
+        return runs_.size();
+    }
+
+    // Run all simulations of the sweep. Every simulation writes its results
+    // to the output file of its configuration, or to the path of its
+    // configuration file followed by ".out".
+    // returns: false if any simulation couldn't be run.
+    bool run();
+
+private:
+    Sweep() = default;
+
+    // Run the simulation of the given configuration file on the executor.
+    // returns: false if the simulation couldn't be run.
+    bool runSimulation(const std::string& config_path, Executor& executor);
+
+    // number of tasks waiting for execution per worker
+    static constexpr size_t PENDING_TASKS_PER_WORKER = 64;
+
+    // configuration files of the simulations in order
+    std::vector<std::string> runs_;
+
+    // number of workers, all available CPUs with an automatic number
+    unsigned int number_of_threads_ {0};
+    bool automatic_threads_ {true};
+
+    // name of the scheduler of the workers
+    std::string scheduler_ {"shared_queue"};
+
+    // number of simulations running at the same time, zero lets the sweep
+    // choose the number
+    unsigned int concurrent_runs_ {0};
+
+    // whether to resume the simulations from their checkpoints
+    bool resume_ {false};
+
+    // instances of the modules kept between the simulations
+    ModuleCache module_cache_;
+
+    // keeps the reports of simulations running at the same time apart
+    std::mutex report_mutex_;
+};
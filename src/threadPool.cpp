@@ -1,93 +1,227 @@
 #include "threadPool.hpp"
+#include "cpuTopology.hpp"
+#include "instrumentation.hpp"
+#include <algorithm>
 #include <iostream>
 
-ThreadPool::ThreadPool(size_t number_of_workers)
+ThreadPool::ThreadPool(size_t number_of_workers, size_t queue_capacity,
+    Instrumentation* instrumentation, const std::vector<std::vector<int>>& worker_cpus)
+    : queue_capacity_(queue_capacity), max_workers_(number_of_workers),
+      active_workers_(number_of_workers), instrumentation_(instrumentation),
+      worker_cpus_(worker_cpus)
 {
-    auto worker = [this]() {
-        while (true) {
-            InternalTaskType task;
-
-            // try to get a task to execute from the shared work queue.
-            // this section is considered critical as race conditions
-            // can happen due to the fact that the underlying queue is
-            // not thread safe.
-            {
-                // lock the critical section since we are going to do
-                // some operations on the shared queue
-                std::unique_lock<std::mutex> lock(mutex_);
-
-                // wait until there are events in the task queue to consume
+    // the worker threads are started by the first submission, so the
+    // number of workers can still be lowered without starting them
+}
+
+// Main loop of the worker thread with the given index.
+void ThreadPool::work(size_t index)
+{
+    // pin the worker before it allocates anything, so its thread local
+    // state is allocated on its NUMA node. Without thread affinity the
+    // worker just runs unpinned.
+    if (index < worker_cpus_.size() && !worker_cpus_[index].empty()) {
+        CpuTopology::pinCurrentThread(worker_cpus_[index]);
+    }
+
+    // timing statistics of this worker, if recorded
+    Instrumentation::ThreadStatistics* statistics = nullptr;
+    if (instrumentation_) {
+        statistics = &instrumentation_->local("worker");
+    }
+    int64_t idle_start = statistics ? Instrumentation::now() : 0;
+
+    while (true) {
+        TaskType task;
+
+        // try to get a task to execute from the shared work queue.
+        // this section is considered critical as race conditions
+        // can happen due to the fact that the underlying queue is
+        // not thread safe.
+        {
+            // lock the critical section since we are going to do
+            // some operations on the shared queue
+            std::unique_lock<std::mutex> lock(mutex_, std::defer_lock);
+            Instrumentation::lock(lock, statistics);
+
+            while (true) {
+                // workers beyond the active ones are parked until they are
+                // needed again or the pool finishes
+                parked_.wait(lock, [this, index]() {
+                    return index < active_workers_ || finished_;
+                });
+
+                // wait until there are tasks in the task queue to consume
                 // or otherwise that we got a signal that there are no more tasks
                 // that will be submitted in the future to wait for
-                condition_.wait(lock, [this](){
-                    return !task_queue_.empty() || finished_;
+                ++idle_workers_;
+                condition_.wait(lock, [this, index](){
+                    return !task_queue_.empty() || finished_ || index >= active_workers_;
                 });
+                --idle_workers_;
 
-                // we need to check after waking up if the wake up signal means
-                // that there are no more work to be done
-                if (finished_ && task_queue_.empty()) {
+                if (index < active_workers_ || finished_) {
                     break;
                 }
 
-                // get the task out of the queue  
-                task = std::move(task_queue_.front());
-                task_queue_.pop();
+                // the worker was parked while waiting, pass on the wake up
+                // it may have taken from an active worker
+                if (!task_queue_.empty()) {
+                    condition_.notify_one();
+                }
             }
-            
-            // execute the task
+
+            // we need to check after waking up if the wake up signal means
+            // that there are no more work to be done
+            if (finished_ && task_queue_.empty()) {
+                break;
+            }
+
+            // get the task out of the queue  
+            task = std::move(task_queue_.front());
+            task_queue_.pop();
+
+            // wake up the producer if it waits for space in the queue
+            if (waiting_for_space_) {
+                waiting_for_space_ = false;
+                space_available_.notify_one();
+            }
+        }
+        
+        // execute the task
+        if (statistics) {
+            int64_t busy_start = Instrumentation::now();
+            task();
+            int64_t busy_end = Instrumentation::now();
+            statistics->idle_time += busy_start - idle_start;
+            statistics->busy_time += busy_end - busy_start;
+            idle_start = busy_end;
+        } else {
             task();
         }
-    };
+    }
+
+    if (statistics) {
+        statistics->idle_time += Instrumentation::now() - idle_start;
+    }
+}
+
+// Change the number of workers executing the tasks. Workers are started
+// when first needed and parked when no longer needed.
+bool ThreadPool::setActiveWorkers(size_t number_of_workers, bool adapt)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        active_workers_ = std::min(number_of_workers, max_workers_);
+        adapt_ = adapt && active_workers_ > 0;
+        adapt_submissions_ = 0;
+        backlog_submissions_ = 0;
+        idle_submissions_ = 0;
+    }
 
-    // construct the worker threads
-    for (size_t i = 0; i < number_of_workers; ++i) {
-        workers_.push_back(std::thread(std::move(worker)));
+    // wake up the parked workers that are needed and let the waiting ones
+    // that are no longer needed park
+    parked_.notify_all();
+    condition_.notify_all();
+    return true;
+}
+
+// Start the worker threads up to the number of active workers.
+void ThreadPool::startWorkers()
+{
+    while (workers_.size() < active_workers_) {
+        workers_.push_back(std::thread(&ThreadPool::work, this, workers_.size()));
     }
 }
 
-// Submits an event to be executed by the workers threads.
+// Count how the queue looked at the last submission and adjust the number of
+// workers once enough submissions are counted. Submissions finding a backlog
+// of tasks mean the workers can't keep up and another one may help,
+// submissions finding idle workers mean there are more workers than work.
+// returns: whether the number of workers changed.
+bool ThreadPool::adapt(bool backlog)
+{
+    if (backlog) {
+        ++backlog_submissions_;
+    } else if (idle_workers_ > 0) {
+        ++idle_submissions_;
+    }
+
+    if (++adapt_submissions_ < ADAPT_INTERVAL) {
+        return false;
+    }
+
+    size_t active_workers = active_workers_;
+    if (backlog_submissions_ * 2 > ADAPT_INTERVAL && active_workers_ < max_workers_) {
+        ++active_workers_;
+    } else if (idle_submissions_ * 2 > ADAPT_INTERVAL && active_workers_ > 1) {
+        --active_workers_;
+    }
+    adapt_submissions_ = 0;
+    backlog_submissions_ = 0;
+    idle_submissions_ = 0;
+
+    return active_workers != active_workers_;
+}
+
+// Submits a task to be executed by the workers threads.
 //
 // If there are no workers -ie: the number of workers was set to be zero-
-// then the events will be executed in the client's thread.
+// then the tasks will be executed in the client's thread.
 // Otherwise this will just enqueue the task and let the workers finish
-// the job.
-ThreadPool::TaskResult ThreadPool::submit(ThreadPool::TaskType&& func,
-    ThreadPool::TaskParamType&& param)
+// the job. If the queue is at its capacity, this blocks the caller until
+// one of the workers takes a task out of the queue.
+void ThreadPool::submit(ThreadPool::TaskType&& task)
 {
-    TaskResult result;
-
     // in case there are no worker threads, we are going to directly execute
     // the task on the caller thread since we have none.
-    if (workers_.size() > 0) {
-        // allocate task to be executed. Exception throwed inside the submitted task
-        // will be stored in the future object so non of our problem here
-        auto task = std::make_shared<std::packaged_task<std::string()>> (
-            std::bind(std::forward<TaskType>(func), std::forward<TaskParamType>(param)));
-        result = task->get_future();
+    if (active_workers_ > 0) {
+        if (workers_.size() < active_workers_) {
+            startWorkers();
+        }
 
         // insert the task in the work queue
         // this is a critical section since we are modifying a shared resource
+        bool workers_changed = false;
         {
             // lock the work queue mutex
-            std::lock_guard<std::mutex> lock(mutex_);
+            std::unique_lock<std::mutex> lock(mutex_, std::defer_lock);
+            Instrumentation::lock(lock, instrumentation_ ? &instrumentation_->local() : nullptr);
+
+            // apply back pressure on the producer while the queue is full
+            bool queue_full = false;
+            if (queue_capacity_ > 0) {
+                space_available_.wait(lock, [this, &queue_full]() {
+                    if (task_queue_.size() < queue_capacity_) {
+                        return true;
+                    }
+                    waiting_for_space_ = true;
+                    queue_full = true;
+                    return false;
+                });
+            }
 
-            // insert the event in the queue wrapped by a simple function
-            // with no return type
-            task_queue_.emplace([task](){(*task)();});
+            // insert the task in the queue
+            task_queue_.push(std::move(task));
+
+            if (adapt_) {
+                workers_changed = adapt(queue_full || task_queue_.size() > active_workers_);
+            }
         }
 
         // notify one of the workers waiting for tasks
         condition_.notify_one();
+
+        if (workers_changed) {
+            startWorkers();
+            parked_.notify_all();
+            condition_.notify_all();
+        }
     } else {
         // execute on caller thread since we have no workers
         // no need for any heap allocations
-        std::packaged_task<std::string(Event)> task(func);
-        result = task.get_future();
-
-        task(param);
+        task();
     }
-
-    return result;
 }
 
 // Block waiting for the execution of all submitted events.
@@ -103,8 +237,10 @@ void ThreadPool::execute()
         finished_ = true;
     }
 
-    // notify all workers about the changes
+    // notify all workers about the changes, parked workers help finishing
+    // the tasks left in the queue
     condition_.notify_all();
+    parked_.notify_all();
 
     // wait for worker threads to finish
     for (auto & worker : workers_) {
@@ -1,4 +1,7 @@
-#include "event.hpp"
+#pragma once
+
+#include "executor.hpp"
+#include "ringBuffer.hpp"
 
 #include <queue>
 #include <vector>
@@ -7,57 +10,109 @@
 #include <mutex>
 #include <condition_variable>
 #include <atomic>
-#include <future>
 
 // Execution manager class that allows for parallel execution of events.
-// Each event is considered an individal task that are submitted to the
+// Each task executes one event or a range of events and is submitted to the
 // pool and executed by one of the pool's worker threads. The number of
 // worker threads is specified by client of the class.
 //
 // Implements a typical producer consumer pattern but with only 1
-// producer and one or more consumers.
-class ThreadPool
+// producer and one or more consumers sharing a single queue.
+class ThreadPool : public Executor
 {
 public:
-    using TaskResult = std::future<std::string>;
-    using TaskParamType = Event;
-    using TaskType = std::function<std::string(TaskParamType)>;
-
     // Constructor by default assumes the execution is on one thread.
-    explicit ThreadPool(size_t number_of_workers = 8);
+    // The queue capacity limits the number of submitted tasks waiting for
+    // execution, zero means the queue is unbounded. The optional
+    // instrumentation records the time the workers are busy and idle and
+    // the time spent waiting for the queue mutex. Workers with CPUs in
+    // worker_cpus are pinned to them.
+    explicit ThreadPool(size_t number_of_workers = 0, size_t queue_capacity = 0,
+        Instrumentation* instrumentation = nullptr,
+        const std::vector<std::vector<int>>& worker_cpus = {});
 
     // Copys are not allowed.
     ThreadPool(const ThreadPool&) = delete;
     ThreadPool& operator=(const ThreadPool&) = delete;
 
-    // Submits an event to be executed by the workers threads.
-    // The parameter fun is the function that executes the simulation
-    // for an event which is passed to it as a parameter.
+    // Submits a task to be executed by the workers threads.
+    // The task executes the simulation of its events and is responsible for
+    // handing its result over, e.g. to an OrderedWriter.
     //
     // If there are no workers -ie: the number of workers was set to be zero-
-    // then the events will be executed in the client's thread.
+    // then the tasks will be executed in the client's thread.
     // Otherwise this will just enqueue the task and let the workers finish
-    // the job.
-    TaskResult submit(TaskType&& func, TaskParamType&& param);
+    // the job. If the queue is at its capacity, this blocks the caller until
+    // one of the workers takes a task out of the queue.
+    void submit(TaskType&& task) override;
+
+    // Change the number of workers executing the tasks. Worker threads are
+    // started by the first submission needing them and workers that are no
+    // longer needed are parked, so lowering the number before the first
+    // submission avoids starting the threads at all. With adapt set, a
+    // worker is added while the submissions find a backlog of tasks and one
+    // is parked while they find idle workers.
+    bool setActiveWorkers(size_t number_of_workers, bool adapt) override;
 
     // Block waiting for the execution of all submitted events.
     // Any tasks submitted after this call will not be executed.
-    void execute();
+    void execute() override;
 
 private:
-    // Internal storage type of task
-    // tasks are wrapped around into a function with no return type or args.
-    using InternalTaskType = std::function<void(void)>;
+    // number of submissions between adjustments of the number of workers
+    static constexpr size_t ADAPT_INTERVAL = 64;
+
+    // Main loop of the worker thread with the given index.
+    void work(size_t index);
+
+    // Start the worker threads up to the number of active workers.
+    void startWorkers();
+
+    // Count the state of the queue at a submission and adjust the number of
+    // active workers every adapt interval.
+    // returns: whether the number of active workers changed.
+    bool adapt(bool backlog);
+
+    // conditional variable parked workers wait on
+    std::condition_variable parked_;
 
     // conditional variable for managing the shared queue
     std::condition_variable condition_;
 
+    // conditional variable signaled when a task is taken out of a full queue
+    std::condition_variable space_available_;
+
+    // maximum number of tasks in the queue, zero means unbounded
+    size_t queue_capacity_ {0};
+
+    // whether the producer is blocked waiting for space in the queue
+    bool waiting_for_space_ {false};
+
+    // number of workers the pool was created with
+    size_t max_workers_ {0};
+
+    // number of workers executing tasks, the others are parked
+    size_t active_workers_ {0};
+
+    // number of workers waiting for tasks
+    size_t idle_workers_ {0};
+
+    // whether the number of active workers is tuned while submitting
+    bool adapt_ {false};
+
+    // submissions since the last adjustment, and the ones finding a backlog
+    // of tasks or idle workers
+    size_t adapt_submissions_ {0};
+    size_t backlog_submissions_ {0};
+    size_t idle_submissions_ {0};
+
     // internal state of the executer. This flag is set when execute method is
     // called to signal the workers to finish the tasks they have.
     bool finished_ {false};
 
-    // task queue
-    std::queue<InternalTaskType> task_queue_;
+    // task queue, backed by a ring buffer so that it doesn't allocate once
+    // it has grown to its largest size
+    std::queue<TaskType, RingBuffer<TaskType>> task_queue_;
 
     // mutex for making thread safe operations on the task queue.
     std::mutex mutex_;
@@ -65,6 +120,12 @@ private:
     // mutex for writing to IO
     std::mutex mutex_io_;
 
+    // optional timing statistics of the workers, null if not recorded
+    Instrumentation* instrumentation_ {nullptr};
+
+    // CPUs each worker is pinned to
+    std::vector<std::vector<int>> worker_cpus_;
+
     // worker threads
     std::vector<std::thread> workers_;
 };
@@ -0,0 +1,192 @@
+#include "workStealingPool.hpp"
+#include "cpuTopology.hpp"
+#include "instrumentation.hpp"
+
+WorkStealingPool::WorkStealingPool(size_t number_of_workers, size_t queue_capacity,
+    Instrumentation* instrumentation, const std::vector<std::vector<int>>& worker_cpus)
+    : instrumentation_(instrumentation)
+{
+    // split the capacity between the workers
+    size_t capacity_per_worker = DEFAULT_QUEUE_CAPACITY;
+    if (number_of_workers > 0 && queue_capacity > 0) {
+        capacity_per_worker = (queue_capacity + number_of_workers - 1) / number_of_workers;
+    }
+
+    for (size_t i = 0; i < number_of_workers; ++i) {
+        queues_.emplace_back(new BoundedQueue<TaskType>(capacity_per_worker));
+    }
+
+    // construct the worker threads once all queues exist since idle
+    // workers start stealing right away
+    for (size_t i = 0; i < number_of_workers; ++i) {
+        workers_.push_back(std::thread(&WorkStealingPool::work, this, i,
+            i < worker_cpus.size() ? worker_cpus[i] : std::vector<int>()));
+    }
+}
+
+// Submits a task to be executed by the workers threads.
+// Tasks are distributed round robin over the queues of the workers. If the
+// queue of the next worker is full, the following ones are tried and the
+// caller blocks only when all of them are full.
+void WorkStealingPool::submit(TaskType&& task)
+{
+    // execute on caller thread since we have no workers
+    if (workers_.empty()) {
+        task();
+        return;
+    }
+
+    while (!push(task)) {
+        // all queues are full, announce we are waiting and retry once more
+        // before sleeping so that a worker freeing space in between is not
+        // missed. The fence pairs with the one in work()
+        std::unique_lock<std::mutex> lock(mutex_);
+        waiting_for_space_.store(true, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+
+        if (push(task)) {
+            waiting_for_space_.store(false, std::memory_order_relaxed);
+            break;
+        }
+
+        space_available_.wait(lock, [this]() {
+            return !waiting_for_space_.load(std::memory_order_relaxed);
+        });
+    }
+
+    // wake up a worker only if some are sleeping. The fence pairs with the
+    // one in work() so either the worker sees the task or we see the worker
+    // sleeping.
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (sleeping_workers_.load(std::memory_order_relaxed) > 0) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        task_available_.notify_one();
+    }
+}
+
+// Push the task to the next queue in round robin order, trying the
+// following queues if it is full.
+bool WorkStealingPool::push(TaskType& task)
+{
+    for (size_t attempt = 0; attempt < queues_.size(); ++attempt) {
+        size_t index = next_queue_;
+        next_queue_ = (next_queue_ + 1) % queues_.size();
+
+        if (queues_[index]->push(std::move(task))) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Block waiting for the execution of all submitted events.
+// Any tasks submitted after this call will not be executed.
+void WorkStealingPool::execute()
+{
+    // signal that task submission is done, the mutex makes sure no worker
+    // is between checking the flag and going to sleep
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        finished_.store(true);
+    }
+    task_available_.notify_all();
+
+    // wait for worker threads to finish
+    for (auto& worker : workers_) {
+        worker.join();
+    }
+}
+
+// Main loop of the worker thread with the given index.
+void WorkStealingPool::work(size_t index, const std::vector<int>& cpus)
+{
+    // pin the worker before it allocates anything, so its thread local
+    // state is allocated on its NUMA node
+    if (!cpus.empty()) {
+        CpuTopology::pinCurrentThread(cpus);
+    }
+
+    TaskType task;
+
+    // timing statistics of this worker, if recorded
+    Instrumentation::ThreadStatistics* statistics = nullptr;
+    if (instrumentation_) {
+        statistics = &instrumentation_->local("worker");
+    }
+    int64_t idle_start = statistics ? Instrumentation::now() : 0;
+
+    while (true) {
+        // look for a task for a while before going to sleep
+        bool found = findTask(index, task);
+        for (int spin = 0; !found && spin < SPIN_COUNT; ++spin) {
+            std::this_thread::yield();
+            found = findTask(index, task);
+        }
+
+        if (found) {
+            // wake up the producer if it waits for space in the queues. The
+            // fence pairs with the one in submit()
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (waiting_for_space_.load(std::memory_order_relaxed)) {
+                {
+                    std::lock_guard<std::mutex> lock(mutex_);
+                    waiting_for_space_.store(false, std::memory_order_relaxed);
+                }
+                space_available_.notify_one();
+            }
+
+            // execute the task
+            if (statistics) {
+                int64_t busy_start = Instrumentation::now();
+                task();
+                int64_t busy_end = Instrumentation::now();
+                statistics->idle_time += busy_start - idle_start;
+                statistics->busy_time += busy_end - busy_start;
+                idle_start = busy_end;
+            } else {
+                task();
+            }
+            continue;
+        }
+
+        // nothing to do, go to sleep until tasks are submitted
+        std::unique_lock<std::mutex> lock(mutex_);
+        sleeping_workers_.fetch_add(1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        task_available_.wait(lock, [this]() {
+            return hasTasks() || finished_.load();
+        });
+        sleeping_workers_.fetch_sub(1, std::memory_order_relaxed);
+
+        // there are no more tasks and no more will be submitted
+        if (finished_.load() && !hasTasks()) {
+            break;
+        }
+    }
+
+    if (statistics) {
+        statistics->idle_time += Instrumentation::now() - idle_start;
+    }
+}
+
+// Take a task from the worker's own queue or steal one from its peers.
+bool WorkStealingPool::findTask(size_t index, TaskType& task)
+{
+    for (size_t i = 0; i < queues_.size(); ++i) {
+        if (queues_[(index + i) % queues_.size()]->pop(task)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Returns whether any of the queues has tasks to execute.
+bool WorkStealingPool::hasTasks() const
+{
+    for (auto& queue : queues_) {
+        if (!queue->empty()) {
+            return true;
+        }
+    }
+    return false;
+}
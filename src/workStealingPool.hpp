@@ -0,0 +1,95 @@
+#pragma once
+
+#include "executor.hpp"
+#include "boundedQueue.hpp"
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+
+// Work stealing executor. Every worker thread owns a lock free queue, the
+// producer distributes the submitted tasks over the queues round robin and
+// each worker takes tasks from its own queue first. A worker that runs out
+// of tasks steals from the queues of its peers before going to sleep.
+//
+// Unlike ThreadPool, there is no lock taken on the hot path. The mutex is
+// only used to put idle workers or a blocked producer to sleep, and nobody
+// is notified unless someone is actually sleeping.
+class WorkStealingPool : public Executor
+{
+public:
+    // Construct the pool with the given number of workers. The queue capacity
+    // is split between the workers, zero selects a default capacity since
+    // the lock free queues are bounded. The optional instrumentation records
+    // the time the workers are busy and idle. Workers with CPUs in
+    // worker_cpus are pinned to them.
+    explicit WorkStealingPool(size_t number_of_workers, size_t queue_capacity = 0,
+        Instrumentation* instrumentation = nullptr,
+        const std::vector<std::vector<int>>& worker_cpus = {});
+
+    // Copys are not allowed.
+    WorkStealingPool(const WorkStealingPool&) = delete;
+    WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+    // Submits a task to be executed by the workers threads.
+    // Blocks the caller while the queues of all workers are full.
+    void submit(TaskType&& task) override;
+
+    // Block waiting for the execution of all submitted events.
+    // Any tasks submitted after this call will not be executed.
+    void execute() override;
+
+private:
+    // default capacity of the queue of each worker
+    static constexpr size_t DEFAULT_QUEUE_CAPACITY = 1024;
+
+    // number of attempts an idle worker makes to find a task before sleeping
+    static constexpr int SPIN_COUNT = 64;
+
+    // Main loop of the worker thread with the given index, pinned to the
+    // given CPUs if any.
+    void work(size_t index, const std::vector<int>& cpus);
+
+    // Push the task to the next queue in round robin order.
+    // returns: false if all queues are full.
+    bool push(TaskType& task);
+
+    // Take a task from the worker's own queue or steal one from its peers.
+    bool findTask(size_t index, TaskType& task);
+
+    // Returns whether any of the queues has tasks to execute.
+    bool hasTasks() const;
+
+    // one queue per worker thread
+    std::vector<std::unique_ptr<BoundedQueue<TaskType>>> queues_;
+
+    // queue that receives the next submitted task
+    size_t next_queue_ {0};
+
+    // internal state of the executer. This flag is set when execute method is
+    // called to signal the workers to finish the tasks they have.
+    std::atomic<bool> finished_ {false};
+
+    // number of workers sleeping waiting for tasks
+    std::atomic<size_t> sleeping_workers_ {0};
+
+    // whether the producer is blocked waiting for space in the queues
+    std::atomic<bool> waiting_for_space_ {false};
+
+    // mutex used to put idle workers and a blocked producer to sleep
+    std::mutex mutex_;
+
+    // conditional variable signaled when tasks are submitted to sleeping workers
+    std::condition_variable task_available_;
+
+    // conditional variable signaled when a task is taken out of full queues
+    std::condition_variable space_available_;
+
+    // optional timing statistics of the workers, null if not recorded
+    Instrumentation* instrumentation_ {nullptr};
+
+    // worker threads
+    std::vector<std::thread> workers_;
+};
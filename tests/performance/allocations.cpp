@@ -0,0 +1,79 @@
+// Counts the heap allocations made while running a simulation.
+//
+// Usage: allocations configuration_file.conf > /dev/null
+//
+// Replaces the global allocation functions with counting ones, runs the
+// simulation described by the configuration file in process and reports
+// the number of allocations made by Simulation::run() per event on standard
+// error. Output of the simulation goes to standard out as usual.
+
+#include "configuration.hpp"
+#include "simulation.hpp"
+
+#include <atomic>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+
+namespace {
+    std::atomic<size_t> allocations {0};
+    std::atomic<size_t> allocated_bytes {0};
+
+    void* allocate(size_t size)
+    {
+        allocations.fetch_add(1, std::memory_order_relaxed);
+        allocated_bytes.fetch_add(size, std::memory_order_relaxed);
+        void* ptr = std::malloc(size > 0 ? size : 1);
+        if (!ptr) {
+            throw std::bad_alloc();
+        }
+        return ptr;
+    }
+}
+
+void* operator new(size_t size) { return allocate(size); }
+void* operator new[](size_t size) { return allocate(size); }
+void* operator new(size_t size, const std::nothrow_t&) noexcept {
+    try { return allocate(size); } catch (...) { return nullptr; }
+}
+void* operator new[](size_t size, const std::nothrow_t&) noexcept {
+    try { return allocate(size); } catch (...) { return nullptr; }
+}
+void operator delete(void* ptr) noexcept { std::free(ptr); }
+void operator delete[](void* ptr) noexcept { std::free(ptr); }
+void operator delete(void* ptr, size_t) noexcept { std::free(ptr); }
+void operator delete[](void* ptr, size_t) noexcept { std::free(ptr); }
+
+int main(int argc, char* argv[])
+{
+    if (argc != 2) {
+        std::cerr << "Usage: allocations /path/to/configuration.file\n";
+        return -1;
+    }
+
+    Configuration config = Configuration::createConfiguration(argv[1]);
+    if (!config.correct()) {
+        std::cerr << "Incorrect configuration file...\n";
+        return -1;
+    }
+
+    Simulation simulation(config);
+    if (!simulation.init()) {
+        return -1;
+    }
+
+    size_t allocations_before = allocations.load();
+    size_t bytes_before = allocated_bytes.load();
+
+    simulation.run();
+
+    size_t run_allocations = allocations.load() - allocations_before;
+    size_t run_bytes = allocated_bytes.load() - bytes_before;
+    double events = config.getNumberOfEvents() > 0 ? config.getNumberOfEvents() : 1;
+
+    std::cerr << "INFO: " << run_allocations << " allocations (" << run_bytes
+        << " bytes) for " << config.getNumberOfEvents() << " events, "
+        << run_allocations / events << " allocations per event\n";
+
+    return 0;
+}
@@ -0,0 +1,99 @@
+// Microbenchmark of the module dispatch.
+//
+// Usage: dispatch [number_of_events]
+//
+// Executes Module1..Module5 for every event in three ways and reports the
+// cost per event as csv on standard out:
+//   virtual   - modules loaded by name and called through Module::run as
+//               Simulation does by default
+//   pipeline  - modules chained in a StaticPipeline, draws still made
+//               through the RandomEngine interface
+//   inlined   - StaticPipeline with the concrete engine type so the whole
+//               event is inlined
+// Each is measured with a cheap engine, where the dispatch cost shows, and
+// with the default mersenne twister.
+
+#include "event.hpp"
+#include "module.hpp"
+#include "module1.hpp"
+#include "module2.hpp"
+#include "module3.hpp"
+#include "module4.hpp"
+#include "module5.hpp"
+#include "outputSink.hpp"
+#include "staticPipeline.hpp"
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+using namespace std::chrono;
+
+namespace {
+    using Pipeline = StaticPipeline<Module1, Module2, Module3, Module4, Module5>;
+
+    // Time the given event function over the number of events and return
+    // the nanoseconds per event.
+    template <typename Function>
+    double measure(unsigned long number_of_events, Function function)
+    {
+        OutputSink output;
+        size_t checksum = 0;
+
+        high_resolution_clock::time_point start_time = high_resolution_clock::now();
+        for (unsigned long i = 0; i < number_of_events; ++i) {
+            output.clear();
+            Event e(static_cast<unsigned int>(i + 1), static_cast<unsigned int>(i * 2654435761u));
+            function(e, output);
+            checksum += output.size();
+        }
+        high_resolution_clock::time_point finish_time = high_resolution_clock::now();
+
+        // keep the output alive so the loop is not optimized away
+        std::cerr << "INFO: checksum " << checksum << '\n';
+        return duration_cast<nanoseconds>(finish_time - start_time).count()
+            / static_cast<double>(number_of_events);
+    }
+
+    template <typename Engine>
+    void benchmark(const char* engine_name, unsigned long number_of_events)
+    {
+        std::vector<std::shared_ptr<Module>> modules;
+        for (const char* name : {"Module1", "Module2", "Module3", "Module4", "Module5"}) {
+            modules.push_back(Module::createModule(name));
+        }
+        Pipeline pipeline;
+        Engine engine;
+        RandomEngine& base_engine = engine;
+
+        double virtual_ns = measure(number_of_events, [&](const Event& e, OutputSink& output) {
+            base_engine.seed(e.getSeed());
+            for (auto& module : modules) {
+                module->run(e, &base_engine, output);
+            }
+        });
+        double pipeline_ns = measure(number_of_events, [&](const Event& e, OutputSink& output) {
+            base_engine.seed(e.getSeed());
+            pipeline.run(e, base_engine, output);
+        });
+        double inlined_ns = measure(number_of_events, [&](const Event& e, OutputSink& output) {
+            engine.seed(e.getSeed());
+            pipeline.run(e, engine, output);
+        });
+
+        std::cout << engine_name << ",virtual," << number_of_events << ',' << virtual_ns << '\n';
+        std::cout << engine_name << ",pipeline," << number_of_events << ',' << pipeline_ns << '\n';
+        std::cout << engine_name << ",inlined," << number_of_events << ',' << inlined_ns << '\n';
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    unsigned long number_of_events = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 1000000;
+
+    std::cout << "engine,dispatch,events,ns_per_event\n";
+    benchmark<SplitMix64Engine>("splitmix64", number_of_events);
+    benchmark<Mt19937Engine>("mt19937", number_of_events / 10);
+
+    return 0;
+}
@@ -0,0 +1,350 @@
+// Benchmark of the simulation engine run in process.
+//
+// Usage: framework_bench [options]
+//   --events N[,N...]         numbers of events             (default 100000)
+//   --threads N[,N...]        numbers of worker threads     (default 1,2,4,8)
+//   --modules LIST[;LIST...]  module lists, modules separated by spaces
+//                             (default "Module1 Module2 Module3 Module4 Module5")
+//   --scheduler NAME          executor scheduler            (default shared_queue)
+//   --engine NAME             random number engine          (default mt19937)
+//   --grain-size N            events per task, 0 for auto   (default 0)
+//   --affinity LIST           worker affinities, none, cpu or node
+//                                                           (default none)
+//   --execution LIST          execution modes, auto, events or blocks
+//                                                           (default auto)
+//   --format csv|json         report format                 (default csv)
+//   --sink null|stream|file   where the results are written (default null)
+//   --output-format text|summary
+//                             format of the results         (default text)
+//   --sink-path PATH          file of the stream and file sinks
+//                                                           (default /dev/null)
+//
+// Runs a simulation for every combination of the matrix and reports per
+// run:
+//   events_per_second  - throughput of Simulation::run
+//   p50/p99/p999_ns    - latency of executing the modules of one event
+//   queue_wait_p50/p99_ns - time a task waited in the executor queue
+//   peak_rss_kb        - peak resident memory of the run
+//   efficiency         - speedup over the run with the fewest threads of the
+//                        same events, modules, affinity and execution,
+//                        divided by the
+//                        thread ratio
+//
+// The results are discarded by the null sink, written through an ofstream by
+// the stream sink, or written by the writer's writev calls to the output
+// file of the configuration by the file sink. Comparing the stream and file
+// sinks shows the cost of writing the results through iostreams.
+//
+// Comparing the affinities, e.g. --affinity none,cpu,node, shows what
+// pinning the workers to CPUs or NUMA nodes gains over unpinned workers.
+//
+// Comparing the output formats shows what aggregating the values of the
+// events into a summary saves over formatting the results of every event.
+//
+// Comparing the execution modes, --execution events,blocks, shows what
+// executing the modules on blocks of events with the random number streams
+// of the events advanced together gains over the loop over single events.
+
+#include "configuration.hpp"
+#include "instrumentation.hpp"
+#include "simulation.hpp"
+
+#include <sys/resource.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <streambuf>
+#include <string>
+#include <vector>
+using namespace std::chrono;
+
+namespace {
+    // Stream buffer discarding everything written to it.
+    class NullBuffer : public std::streambuf
+    {
+    protected:
+        int_type overflow(int_type ch) override {
+            return traits_type::not_eof(ch);
+        }
+
+        std::streamsize xsputn(const char*, std::streamsize count) override {
+            return count;
+        }
+    };
+
+    // Measurements of one simulation run.
+    struct Result {
+        unsigned long events;
+        unsigned long threads;
+        std::string affinity;
+        std::string execution;
+        std::string modules;
+        double events_per_second;
+        uint64_t p50_ns;
+        uint64_t p99_ns;
+        uint64_t p999_ns;
+        uint64_t queue_wait_p50_ns;
+        uint64_t queue_wait_p99_ns;
+        long peak_rss_kb;
+        double efficiency;
+    };
+
+    // Split the text at every separator, skipping empty parts.
+    std::vector<std::string> split(const std::string& text, char separator)
+    {
+        std::vector<std::string> parts;
+        std::stringstream stream(text);
+        std::string part;
+        while (std::getline(stream, part, separator)) {
+            if (!part.empty()) {
+                parts.push_back(part);
+            }
+        }
+        return parts;
+    }
+
+    std::vector<unsigned long> parseNumbers(const std::string& text)
+    {
+        std::vector<unsigned long> numbers;
+        for (const std::string& part : split(text, ',')) {
+            numbers.push_back(std::strtoul(part.c_str(), nullptr, 10));
+        }
+        return numbers;
+    }
+
+    // Reset the peak resident memory of the process to the current one.
+    // Not available on every kernel, the peak then covers all earlier runs.
+    void resetPeakRss()
+    {
+        std::ofstream clear_refs("/proc/self/clear_refs");
+        clear_refs << "5";
+    }
+
+    // Returns the peak resident memory of the process in kilobytes.
+    long getPeakRss()
+    {
+        std::ifstream status("/proc/self/status");
+        std::string line;
+        while (std::getline(status, line)) {
+            if (line.compare(0, 6, "VmHWM:") == 0) {
+                return std::strtol(line.c_str() + 6, nullptr, 10);
+            }
+        }
+
+        struct rusage usage;
+        getrusage(RUSAGE_SELF, &usage);
+        return usage.ru_maxrss;
+    }
+
+    // Run one simulation and measure it. Returns false if the configuration
+    // is not valid.
+    bool runSimulation(const std::string& config_text, const std::string& sink,
+        const std::string& sink_path, Result& result)
+    {
+        std::istringstream config_stream(config_text);
+        Configuration config = Configuration::createConfiguration(config_stream);
+        if (!config.correct()) {
+            return false;
+        }
+
+        // the engine reports its progress on standard out, keep it quiet
+        NullBuffer null_buffer;
+        std::ostream null_output(&null_buffer);
+        std::streambuf* cout_buffer = std::cout.rdbuf(&null_buffer);
+
+        Instrumentation instrumentation;
+        Simulation simulation(config);
+        bool initialized = simulation.init();
+        if (initialized) {
+            simulation.setInstrumentation(&instrumentation);
+            resetPeakRss();
+
+            std::ofstream stream_output;
+            if (sink == "stream") {
+                stream_output.open(sink_path, std::ios::binary | std::ios::trunc);
+            }
+
+            high_resolution_clock::time_point start_time = high_resolution_clock::now();
+            if (sink == "stream") {
+                simulation.run(stream_output);
+                stream_output.flush();
+            } else if (sink == "file") {
+                simulation.run();
+            } else {
+                simulation.run(null_output);
+            }
+            high_resolution_clock::time_point finish_time = high_resolution_clock::now();
+
+            double seconds = duration_cast<nanoseconds>(finish_time - start_time).count() / 1e9;
+            result.events_per_second = result.events / seconds;
+            result.peak_rss_kb = getPeakRss();
+        }
+
+        std::cout.rdbuf(cout_buffer);
+        if (!initialized) {
+            return false;
+        }
+
+        Instrumentation::ThreadStatistics statistics = instrumentation.merge();
+        result.p50_ns = statistics.event_time.getPercentile(50);
+        result.p99_ns = statistics.event_time.getPercentile(99);
+        result.p999_ns = statistics.event_time.getPercentile(99.9);
+        result.queue_wait_p50_ns = statistics.queue_wait.getPercentile(50);
+        result.queue_wait_p99_ns = statistics.queue_wait.getPercentile(99);
+        return true;
+    }
+
+    void printCsv(const std::vector<Result>& results)
+    {
+        std::cout << "events,threads,affinity,execution,modules,events_per_second,p50_ns,p99_ns,p999_ns,"
+            "queue_wait_p50_ns,queue_wait_p99_ns,peak_rss_kb,efficiency\n";
+        for (const Result& r : results) {
+            std::cout << r.events << ',' << r.threads << ',' << r.affinity << ',' << r.execution << ",\"" << r.modules << "\","
+                << r.events_per_second << ',' << r.p50_ns << ',' << r.p99_ns << ','
+                << r.p999_ns << ',' << r.queue_wait_p50_ns << ',' << r.queue_wait_p99_ns << ','
+                << r.peak_rss_kb << ',' << r.efficiency << '\n';
+        }
+    }
+
+    void printJson(const std::vector<Result>& results)
+    {
+        std::cout << "[\n";
+        for (size_t i = 0; i < results.size(); ++i) {
+            const Result& r = results[i];
+            std::cout << "  {\"events\": " << r.events << ", \"threads\": " << r.threads
+                << ", \"affinity\": \"" << r.affinity << "\""
+                << ", \"execution\": \"" << r.execution << "\""
+                << ", \"modules\": \"" << r.modules << "\""
+                << ", \"events_per_second\": " << r.events_per_second
+                << ", \"p50_ns\": " << r.p50_ns << ", \"p99_ns\": " << r.p99_ns
+                << ", \"p999_ns\": " << r.p999_ns
+                << ", \"queue_wait_p50_ns\": " << r.queue_wait_p50_ns
+                << ", \"queue_wait_p99_ns\": " << r.queue_wait_p99_ns
+                << ", \"peak_rss_kb\": " << r.peak_rss_kb
+                << ", \"efficiency\": " << r.efficiency << '}'
+                << (i + 1 < results.size() ? ",\n" : "\n");
+        }
+        std::cout << "]\n";
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    std::vector<unsigned long> event_counts {100000};
+    std::vector<unsigned long> thread_counts {1, 2, 4, 8};
+    std::vector<std::string> module_lists {"Module1 Module2 Module3 Module4 Module5"};
+    std::string scheduler = "shared_queue";
+    std::string engine = "mt19937";
+    std::string grain_size = "0";
+    std::vector<std::string> affinities {"none"};
+    std::vector<std::string> executions {"auto"};
+    std::string format = "csv";
+    std::string sink = "null";
+    std::string sink_path = "/dev/null";
+    std::string output_format = "text";
+
+    for (int i = 1; i < argc; ++i) {
+        std::string option = argv[i];
+        if (i + 1 >= argc) {
+            std::cerr << "ERROR: Missing value of option " << option << '\n';
+            return -1;
+        }
+        std::string value = argv[++i];
+
+        if (option == "--events") {
+            event_counts = parseNumbers(value);
+        } else if (option == "--threads") {
+            thread_counts = parseNumbers(value);
+        } else if (option == "--modules") {
+            module_lists = split(value, ';');
+        } else if (option == "--scheduler") {
+            scheduler = value;
+        } else if (option == "--engine") {
+            engine = value;
+        } else if (option == "--grain-size") {
+            grain_size = value;
+        } else if (option == "--affinity") {
+            affinities = split(value, ',');
+        } else if (option == "--execution") {
+            executions = split(value, ',');
+        } else if (option == "--format" && (value == "csv" || value == "json")) {
+            format = value;
+        } else if (option == "--sink" && (value == "null" || value == "stream" || value == "file")) {
+            sink = value;
+        } else if (option == "--output-format" && (value == "text" || value == "summary")) {
+            output_format = value;
+        } else if (option == "--sink-path") {
+            sink_path = value;
+        } else {
+            std::cerr << "ERROR: Invalid option " << option << ' ' << value << '\n';
+            return -1;
+        }
+    }
+
+    std::vector<Result> results;
+    for (const std::string& modules : module_lists) {
+        for (unsigned long events : event_counts) {
+            for (const std::string& affinity : affinities) {
+                for (const std::string& execution : executions) {
+                    size_t first_result = results.size();
+
+                    for (unsigned long threads : thread_counts) {
+                        std::ostringstream config_text;
+                        config_text << "number_of_events = " << events << '\n'
+                            << "number_of_threads = " << threads << '\n'
+                            << "initial_seed = 32435324234\n"
+                            << "modules = " << modules << '\n'
+                            << "scheduler = " << scheduler << '\n'
+                            << "random_engine = " << engine << '\n'
+                            << "grain_size = " << grain_size << '\n'
+                            << "worker_affinity = " << affinity << '\n'
+                            << "execution = " << execution << '\n'
+                            << "output_format = " << output_format << '\n';
+                        if (sink == "file") {
+                            config_text << "output_file = " << sink_path << '\n';
+                        }
+
+                        Result result {};
+                        result.events = events;
+                        result.threads = threads;
+                        result.affinity = affinity;
+                        result.execution = execution;
+                        result.modules = modules;
+                        if (!runSimulation(config_text.str(), sink, sink_path, result)) {
+                            std::cerr << "ERROR: Invalid benchmark configuration:\n" << config_text.str();
+                            return -1;
+                        }
+                        std::cerr << "INFO: " << events << " events, " << threads << " threads, "
+                            << affinity << " affinity, " << execution << " execution, " << modules << ": "
+                            << result.events_per_second << " events/s\n";
+                        results.push_back(result);
+                    }
+
+                    // scaling relative to the run with the fewest threads
+                    auto base = std::min_element(results.begin() + first_result, results.end(),
+                        [](const Result& a, const Result& b) { return a.threads < b.threads; });
+                    if (base != results.end()) {
+                        double base_threads = std::max<unsigned long>(1, base->threads);
+                        for (size_t i = first_result; i < results.size(); ++i) {
+                            double speedup = results[i].events_per_second / base->events_per_second;
+                            double thread_ratio = std::max<unsigned long>(1, results[i].threads) / base_threads;
+                            results[i].efficiency = speedup / thread_ratio;
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    if (format == "json") {
+        printJson(results);
+    } else {
+        printCsv(results);
+    }
+
+    return 0;
+}
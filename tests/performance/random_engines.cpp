@@ -0,0 +1,166 @@
+// Microbenchmark of the random number engines.
+//
+// Usage: random_engines [number_of_events]
+//
+// For every engine measures the cost of what an event does with it: seeding
+// the engine with the seed of the event followed by two draws per module for
+// 3 modules. Also measures the cost of a draw alone. Results are written as
+// csv to standard out.
+//
+// The events execution is the loop over single events of Simulation::run,
+// the blocks executions seed and draw the streams of 16 events at once with
+// a MultiStreamEngine using each instruction set the machine supports. The
+// numbers drawn by the blocks are checked against the single events.
+
+#include "multiStreamEngine.hpp"
+#include "randomEngine.hpp"
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+using namespace std::chrono;
+
+namespace {
+    const int draws_per_event = 6;
+
+    RandomEngine::result_type eventSeed(unsigned long event) {
+        return static_cast<RandomEngine::result_type>(event * 2654435761u);
+    }
+
+    const char* getInstructionSetName(MultiStreamEngine::InstructionSet instruction_set) {
+        switch (instruction_set) {
+        case MultiStreamEngine::InstructionSet::AVX512:
+            return "avx512";
+        case MultiStreamEngine::InstructionSet::AVX2:
+            return "avx2";
+        default:
+            return "scalar";
+        }
+    }
+
+    // Returns whether the streams draw the same numbers as the engine for
+    // the events of a block.
+    bool checkStreams(RandomEngine& engine, MultiStreamEngine& streams) {
+        const size_t lanes = MultiStreamEngine::LANES;
+        uint32_t seeds[lanes];
+        for (size_t lane = 0; lane < lanes; ++lane) {
+            seeds[lane] = eventSeed(lane);
+        }
+
+        // long enough for the mersenne twister to twist its state twice
+        const int draws = 1500;
+        std::vector<uint32_t> values(draws * lanes);
+        streams.seed(seeds, lanes);
+        for (int draw = 0; draw < draws; ++draw) {
+            streams.draw(&values[draw * lanes]);
+        }
+
+        for (size_t lane = 0; lane < lanes; ++lane) {
+            engine.seed(seeds[lane]);
+            for (int draw = 0; draw < draws; ++draw) {
+                if (values[draw * lanes + lane] != engine()) {
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    unsigned long number_of_events = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 1000000;
+    const unsigned long number_of_draws = number_of_events * 16;
+    const size_t lanes = MultiStreamEngine::LANES;
+
+    std::vector<std::string> engines = {"mt19937", "splitmix64", "xoshiro128", "philox4x32"};
+
+    std::vector<MultiStreamEngine::InstructionSet> instruction_sets = {MultiStreamEngine::InstructionSet::SCALAR};
+    if (MultiStreamEngine::getInstructionSet() >= MultiStreamEngine::InstructionSet::AVX2) {
+        instruction_sets.push_back(MultiStreamEngine::InstructionSet::AVX2);
+    }
+    if (MultiStreamEngine::getInstructionSet() >= MultiStreamEngine::InstructionSet::AVX512) {
+        instruction_sets.push_back(MultiStreamEngine::InstructionSet::AVX512);
+    }
+
+    std::cout << "engine,execution,events,ns_per_event,draws,ns_per_draw\n";
+    for (const std::string& name : engines) {
+        std::unique_ptr<RandomEngine> engine = RandomEngine::createRandomEngine(name);
+
+        // keep the drawn numbers alive so the loops are not optimized away
+        RandomEngine::result_type checksum = 0;
+
+        // seed per event followed by the draws of the event
+        high_resolution_clock::time_point start_time = high_resolution_clock::now();
+        for (unsigned long event = 0; event < number_of_events; ++event) {
+            engine->seed(eventSeed(event));
+            for (int draw = 0; draw < draws_per_event; ++draw) {
+                checksum ^= (*engine)();
+            }
+        }
+        high_resolution_clock::time_point finish_time = high_resolution_clock::now();
+        double event_ns = duration_cast<nanoseconds>(finish_time - start_time).count()
+            / static_cast<double>(number_of_events);
+
+        // draws only
+        engine->seed(1);
+        start_time = high_resolution_clock::now();
+        for (unsigned long draw = 0; draw < number_of_draws; ++draw) {
+            checksum ^= (*engine)();
+        }
+        finish_time = high_resolution_clock::now();
+        double draw_ns = duration_cast<nanoseconds>(finish_time - start_time).count()
+            / static_cast<double>(number_of_draws);
+
+        std::cout << name << ",events," << number_of_events << ',' << event_ns << ','
+            << number_of_draws << ',' << draw_ns << '\n';
+
+        for (MultiStreamEngine::InstructionSet instruction_set : instruction_sets) {
+            std::unique_ptr<MultiStreamEngine> streams =
+                MultiStreamEngine::createMultiStreamEngine(name, instruction_set);
+            std::string execution = std::string("blocks_") + getInstructionSetName(instruction_set);
+            if (!checkStreams(*engine, *streams)) {
+                std::cerr << "ERROR: " << name << ' ' << execution
+                    << " streams differ from the engine\n";
+                return -1;
+            }
+
+            // blocks of events seeded together followed by their draws
+            uint32_t seeds[lanes];
+            uint32_t values[lanes];
+            start_time = high_resolution_clock::now();
+            for (unsigned long event = 0; event < number_of_events; event += lanes) {
+                for (size_t lane = 0; lane < lanes; ++lane) {
+                    seeds[lane] = eventSeed(event + lane);
+                }
+                streams->seed(seeds, lanes);
+                for (int draw = 0; draw < draws_per_event; ++draw) {
+                    streams->draw(values);
+                    checksum ^= values[0];
+                }
+            }
+            finish_time = high_resolution_clock::now();
+            event_ns = duration_cast<nanoseconds>(finish_time - start_time).count()
+                / static_cast<double>(number_of_events);
+
+            // draws only, counted per stream
+            streams->seed(seeds, lanes);
+            start_time = high_resolution_clock::now();
+            for (unsigned long draw = 0; draw < number_of_draws; draw += lanes) {
+                streams->draw(values);
+                checksum ^= values[0];
+            }
+            finish_time = high_resolution_clock::now();
+            draw_ns = duration_cast<nanoseconds>(finish_time - start_time).count()
+                / static_cast<double>(number_of_draws);
+
+            std::cout << name << ',' << execution << ',' << number_of_events << ',' << event_ns << ','
+                << number_of_draws << ',' << draw_ns << '\n';
+        }
+        std::cerr << "INFO: checksum " << checksum << '\n';
+    }
+
+    return 0;
+}
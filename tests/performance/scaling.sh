@@ -0,0 +1,28 @@
+#!/bin/bash
+# Scaling benchmark of the schedulers. Runs the same simulation with an
+# increasing number of threads for each scheduler and reports the throughput
+# in events per second as csv in scaling.log.
+
+EVENTS=${1:-1000000}
+FRAMEWORK=${FRAMEWORK:-../../build/bin/framework}
+
+echo "scheduler,threads,events,ms,events_per_sec" | tee scaling.log
+for scheduler in shared_queue work_stealing; do
+	for cpu in 1 2 4 8 16 32 64; do
+		# generate test file configuration
+		echo "number_of_events = $EVENTS" > scaling.conf
+		echo "number_of_threads = $cpu" >> scaling.conf
+		echo "scheduler = $scheduler" >> scaling.conf
+		echo "initial_seed = 1" >> scaling.conf
+		echo "modules = Module1 Module2 Module3" >> scaling.conf
+
+		# run the test, the execution time is the line before last
+		ms=$($FRAMEWORK -v scaling.conf | tail -n 2 | head -n 1 | sed -e 's/.* in \([0-9]*\) ms/\1/')
+		if [ "$ms" -eq "0" ]; then
+			ms=1
+		fi
+		echo "$scheduler,$cpu,$EVENTS,$ms,$((EVENTS * 1000 / ms))" | tee -a scaling.log
+	done
+done
+
+rm -rf scaling.conf
@@ -5,10 +5,9 @@ for event in 100 1000 10000 100000 1000000 10000000; do
 		echo "#events=$event, #cpu=$cpu" | tee -a run.log
 		
 		# generate test file configuration
+		# the number of threads is fixed, the default adapts it to the events
 		echo "number_of_events = $event" > sample.conf
-		if [ "$cpu" -ne "1" ]; then
-			echo "number_of_threads = $cpu" >> sample.conf
-		fi
+		echo "number_of_threads = $cpu" >> sample.conf
 		echo "modules = Module1 Module2 Module3" >> sample.conf
 
 		# run the test
@@ -18,3 +17,11 @@ for event in 100 1000 10000 100000 1000000 10000000; do
 done
 
 rm -rf sample.conf tmp
+
+# throughput of writing the results through iostreams and through the writer
+for sink in stream file; do
+	echo "#sink=$sink" | tee -a run.log
+	../../build/bin/framework_bench --events 1000000 --threads 1,4 --sink $sink --sink-path sink.out >> run.log
+done
+
+rm -rf sink.out
@@ -25,6 +25,472 @@ for test in $DIR/same_seed/*.conf; do
     fi
 done
 
+# test shards run by separate processes merge into the single process results
+echo "testing sharded simulations merge into the same result..."
+for test in $DIR/same_seed/*.conf $DIR/lifecycle/*.conf; do
+    name=$(basename $test)
+    ../bin/framework $test > test_output/shard_$name.out 2>&1
+    for shard in 1 2 3; do
+        ../bin/framework --shard $shard/3 $test > test_output/shard_$name.$shard 2>&1 &
+    done
+    wait
+    ../bin/framework_merge test_output/shard_$name.1 test_output/shard_$name.2 test_output/shard_$name.3 > test_output/merged_$name.out
+
+    if cmp -s test_output/shard_$name.out test_output/merged_$name.out ; then
+        echo "passed ${test}"
+    else
+        echo "failed ${test}" >&2
+
+        rm -rf test_output
+        exit 1;
+    fi
+done
+
+# the timing statistics of the shards are left out, their counts still add up
+(cat $DIR/lifecycle/test1.conf; echo; echo "instrumentation = on") > test_output/shard_instrumented.conf
+for shard in 1 2 3; do
+    ../bin/framework --shard $shard/3 test_output/shard_instrumented.conf > test_output/shard_instrumented.$shard 2>&1
+done
+if ../bin/framework_merge test_output/shard_instrumented.1 test_output/shard_instrumented.2 test_output/shard_instrumented.3 > test_output/merged_instrumented.out &&
+    cmp -s <(grep -v "^INFO: [a-z]" test_output/merged_instrumented.out) test_output/shard_test1.conf.out ; then
+    echo "passed shards with instrumentation"
+else
+    echo "failed shards with instrumentation" >&2
+
+    rm -rf test_output
+    exit 1;
+fi
+
+# test workers pinned to CPUs or NUMA nodes produce the same results
+echo "testing pinned workers produce the same result..."
+for test in $DIR/same_seed/*.conf; do
+    name=$(basename $test)
+    ../bin/framework $test > test_output/unpinned_$name.out 2>&1
+    for affinity in cpu node; do
+        (cat $test; echo; echo "worker_affinity = $affinity") > test_output/${affinity}_$name
+        ../bin/framework test_output/${affinity}_$name > test_output/${affinity}_$name.out 2>&1
+
+        if cmp -s test_output/unpinned_$name.out test_output/${affinity}_$name.out ; then
+            echo "passed ${test} with ${affinity} affinity"
+        else
+            echo "failed ${test} with ${affinity} affinity" >&2
+
+            rm -rf test_output
+            exit 1;
+        fi
+    done
+done
+
+# test modules executed as a pipeline produce the same results
+echo "testing pipelined modules produce the same result..."
+for test in $DIR/same_seed/*.conf; do
+    name=$(basename $test)
+    ../bin/framework $test > test_output/events_$name.out 2>&1
+    (cat $test; echo; echo "execution = pipeline") > test_output/pipeline_$name
+    ../bin/framework test_output/pipeline_$name > test_output/pipeline_$name.out 2>&1
+
+    if cmp -s test_output/events_$name.out test_output/pipeline_$name.out ; then
+        echo "passed ${test} with pipeline execution"
+    else
+        echo "failed ${test} with pipeline execution" >&2
+
+        rm -rf test_output
+        exit 1;
+    fi
+done
+
+# test modules executed as a graph produce the same results whatever executes
+# them, every module drawing from its own stream
+echo "testing graphs of modules produce the same result..."
+for test in $DIR/same_seed/*.conf; do
+    name=$(basename $test)
+    modules=($(sed -n "s/^modules = //p" $test))
+    dependencies="module_dependencies = ${modules[2]} ${modules[0]} ${modules[1]}"
+    (cat $test; echo; echo "execution = graph"; echo "$dependencies"; echo "number_of_threads = 0") > test_output/graph_$name
+    ../bin/framework test_output/graph_$name > test_output/graph_$name.out 2>&1
+
+    for execution in "number_of_threads = 4" "scheduler = work_stealing" "grain_size = 1"; do
+        (cat $test; echo; echo "execution = graph"; echo "$dependencies"; echo "$execution") > test_output/graph_$name
+        ../bin/framework test_output/graph_$name > test_output/graph_execution_$name.out 2>&1
+
+        if cmp -s test_output/graph_$name.out test_output/graph_execution_$name.out ; then
+            echo "passed ${test} with graph execution and ${execution}"
+        else
+            echo "failed ${test} with graph execution and ${execution}" >&2
+
+            rm -rf test_output
+            exit 1;
+        fi
+    done
+done
+
+# dependencies of the modules are only used by the graph
+(cat $DIR/test1.conf; echo; echo "execution = events"; echo "module_dependencies = Module5 Module1") > test_output/dependencies.conf
+if ../bin/framework test_output/dependencies.conf > /dev/null 2>&1 ; then
+    echo "failed module dependencies with events execution" >&2
+
+    rm -rf test_output
+    exit 1;
+else
+    echo "passed module dependencies with events execution"
+fi
+
+# stages of the modules are only used by the pipeline
+(cat $DIR/test1.conf; echo; echo "execution = events"; echo "pipeline_stages = 1 1") > test_output/stages.conf
+if ../bin/framework test_output/stages.conf > /dev/null 2>&1 ; then
+    echo "failed pipeline stages with events execution" >&2
+
+    rm -rf test_output
+    exit 1;
+else
+    echo "passed pipeline stages with events execution"
+fi
+
+# test modules executing blocks of events produce the same results with every
+# random number engine
+echo "testing blocks of events produce the same result..."
+for test in $DIR/same_seed/*.conf $DIR/binary_output/*.conf; do
+    name=$(basename $(dirname $test))_$(basename $test)
+    for engine in mt19937 splitmix64 xoshiro128 philox4x32; do
+        for execution in events blocks; do
+            (cat $test; echo; echo "random_engine = $engine"; echo "execution = $execution"
+             echo "output_file = test_output/${execution}_$name.res") > test_output/${execution}_$name
+            ../bin/framework test_output/${execution}_$name > /dev/null 2>&1
+        done
+
+        if cmp -s test_output/events_$name.res test_output/blocks_$name.res ; then
+            echo "passed ${test} with blocks of events and ${engine}"
+        else
+            echo "failed ${test} with blocks of events and ${engine}" >&2
+
+            rm -rf test_output
+            exit 1;
+        fi
+    done
+done
+
+# test the events read their records of the input file, indexed or of fixed
+# size records, with every execution
+echo "testing events read their records of the input file..."
+seq 1 2000 > test_output/input_lines.txt
+../bin/framework_pack test_output/input_lines.txt test_output/input_indexed.bin
+printf '%08d' $(seq 1 2000) > test_output/input_fixed.txt
+for input in indexed fixed; do
+    for execution in events blocks pipeline; do
+        (echo "number_of_events = 2000"; echo "number_of_threads = 4"; echo "grain_size = 7"
+         echo "modules = Module1 InputReader Module2"; echo "execution = $execution"
+         if [ $input = indexed ]; then
+             echo "input_file = test_output/input_indexed.bin"
+         else
+             echo "input_file = test_output/input_fixed.txt"; echo "input_record_size = 8"
+         fi) > test_output/input.conf
+        ../bin/framework test_output/input.conf > test_output/input.out 2>&1
+
+        # every event holds its own number read from the input file
+        if awk '/^event #/ { event = substr($2, 2) }
+                /^InputReader_/ { split($0, value, "_"); if (value[2] + 0 == event) ++records }
+                END { exit records != 2000 }' test_output/input.out ; then
+            echo "passed ${input} input file with ${execution} execution"
+        else
+            echo "failed ${input} input file with ${execution} execution" >&2
+
+            rm -rf test_output
+            exit 1;
+        fi
+    done
+done
+
+# test the summary of a run is the same whatever the number of threads and
+# the execution
+echo "testing summaries are deterministic..."
+for test in $DIR/same_seed/*.conf; do
+    name=$(basename $test)
+    (cat $test; echo; echo "output_format = summary"; echo "number_of_threads = 0") > test_output/summary_$name
+    ../bin/framework test_output/summary_$name | grep -v "^INFO" > test_output/summary_$name.out 2>&1
+    if ! grep -q "^summary of [0-9]* events$" test_output/summary_$name.out ; then
+        echo "failed ${test} summary" >&2
+
+        rm -rf test_output
+        exit 1;
+    fi
+
+    for execution in "number_of_threads = 4" "scheduler = work_stealing" "execution = events" "execution = pipeline"; do
+        (cat $test; echo; echo "output_format = summary"; echo "$execution") > test_output/summary_$name
+        ../bin/framework test_output/summary_$name | grep -v "^INFO" > test_output/summary_execution_$name.out 2>&1
+
+        if cmp -s test_output/summary_$name.out test_output/summary_execution_$name.out ; then
+            echo "passed ${test} summary with ${execution}"
+        else
+            echo "failed ${test} summary with ${execution}" >&2
+
+            rm -rf test_output
+            exit 1;
+        fi
+    done
+done
+
+# test the modules of all threads are merged when the run ends
+echo "testing modules of the threads are merged..."
+for test in $DIR/lifecycle/*.conf; do
+    name=$(basename $test)
+    events=$(grep "^number_of_events" $test | awk '{print $3}')
+    for execution in "number_of_threads = 0" "number_of_threads = 4" "scheduler = work_stealing" "execution = events" "execution = pipeline"; do
+        (cat $test; echo "$execution") > test_output/lifecycle_$name
+        ../bin/framework test_output/lifecycle_$name > test_output/lifecycle_$name.out 2>&1
+
+        if grep -q "^INFO: EventCounter counted $events events$" test_output/lifecycle_$name.out ; then
+            echo "passed ${test} with ${execution}"
+        else
+            echo "failed ${test} with ${execution}" >&2
+
+            rm -rf test_output
+            exit 1;
+        fi
+    done
+done
+
+# test a sweep of simulations in one process gives the results of separate runs
+echo "testing a sweep produces the same results..."
+mkdir test_output/sweep
+echo "concurrent_runs = 3" > test_output/sweep/sweep.txt
+for test in $DIR/same_seed/*.conf $DIR/lifecycle/*.conf; do
+    name=$(basename $(dirname $test))_$(basename $test)
+    cp $test test_output/sweep/$name
+    echo "run = test_output/sweep/$name" >> test_output/sweep/sweep.txt
+done
+../bin/framework --sweep test_output/sweep/sweep.txt > test_output/sweep/sweep.out 2>&1
+for test in $DIR/same_seed/*.conf; do
+    name=same_seed_$(basename $test)
+    ../bin/framework $test | grep -v "^Framework\|^INFO\|^Terminating" > test_output/sweep/$name.expected
+
+    if cmp -s test_output/sweep/$name.expected test_output/sweep/$name.out ; then
+        echo "passed ${test} in a sweep"
+    else
+        echo "failed ${test} in a sweep" >&2
+
+        rm -rf test_output
+        exit 1;
+    fi
+done
+if grep -q "^INFO: EventCounter counted 10000 events$" test_output/sweep/sweep.out ; then
+    echo "passed modules merged in a sweep"
+else
+    echo "failed modules merged in a sweep" >&2
+
+    rm -rf test_output
+    exit 1;
+fi
+
+# a sweep with a run whose results can't be written fails
+(cat $DIR/test1.conf; echo; echo "output_file = /dev/full") > test_output/sweep/full.conf
+(cat test_output/sweep/sweep.txt; echo "run = test_output/sweep/full.conf") > test_output/sweep/full.txt
+if ../bin/framework --sweep test_output/sweep/full.txt > /dev/null 2>&1 ; then
+    echo "failed sweep with a failing run" >&2
+
+    rm -rf test_output
+    exit 1;
+else
+    echo "passed sweep with a failing run"
+fi
+
+# test jobs submitted to a server give the results of separate runs
+echo "testing jobs submitted to a server produce the same results..."
+mkdir test_output/server
+../bin/framework --serve test_output/server/socket > test_output/server/server.out 2>&1 &
+server=$!
+for i in $(seq 100); do
+    [ -S test_output/server/socket ] && break
+    sleep 0.1
+done
+for test in $DIR/same_seed/*.conf; do
+    name=$(basename $test)
+    ../bin/framework --submit test_output/server/socket $test 2>&1 | grep -v "^Framework\|^Terminating" > test_output/server/$name.out &
+    ../bin/framework --submit test_output/server/socket --output test_output/server/$name.file $test > /dev/null 2>&1 &
+done
+wait $(jobs -p | grep -v "^$server$")
+for test in $DIR/same_seed/*.conf; do
+    name=$(basename $test)
+    ../bin/framework $test | grep -v "^Framework\|^INFO\|^Terminating" > test_output/server/$name.expected
+
+    if cmp -s test_output/server/$name.expected test_output/server/$name.out \
+            && cmp -s test_output/server/$name.expected test_output/server/$name.file ; then
+        echo "passed ${test} on a server"
+    else
+        echo "failed ${test} on a server" >&2
+
+        kill $server
+        rm -rf test_output
+        exit 1;
+    fi
+done
+
+# a job whose results can't be written fails the client
+../bin/framework --submit test_output/server/socket --output /dev/full $DIR/test1.conf > /dev/null 2>&1
+if [ $? -ne 0 ] && [ "$(stat -c %a test_output/server/socket)" = "600" ] ; then
+    echo "passed failed job on a server"
+else
+    echo "failed failed job on a server" >&2
+
+    kill $server
+    rm -rf test_output
+    exit 1;
+fi
+
+kill $server
+wait $server
+if [ $? -eq 0 ] && [ ! -e test_output/server/socket ] ; then
+    echo "passed server stopped"
+else
+    echo "failed server stopped" >&2
+
+    rm -rf test_output
+    exit 1;
+fi
+
+# test results taken from the result cache are the results of executing the
+# modules, the second run of every simulation takes all of them from the cache
+echo "testing results taken from the result cache..."
+for test in $DIR/same_seed/*.conf; do
+    name=$(basename $test)
+    ../bin/framework $test | grep -v "^Framework\|^INFO\|^Terminating" > test_output/cached_$name.expected
+    (cat $test; echo; echo "result_cache = test_output/result_cache") > test_output/cached_$name
+
+    for run in cold warm; do
+        ../bin/framework test_output/cached_$name > test_output/cached_$name.$run
+        grep -v "^Framework\|^INFO\|^Terminating" test_output/cached_$name.$run > test_output/cached_$name.out
+
+        if cmp -s test_output/cached_$name.expected test_output/cached_$name.out \
+                && ( [ $run = cold ] || grep -q "^INFO: Took \([0-9]*\) of \1 module results" test_output/cached_$name.$run ) ; then
+            echo "passed ${test} ${run}"
+        else
+            echo "failed ${test} ${run}" >&2
+
+            rm -rf test_output
+            exit 1;
+        fi
+    done
+done
+
+# test a shard takes the batches of the whole run from the cache, as they are
+# named by the numbers of their events, and temporary files left behind are
+# removed
+../bin/framework --shard 2/3 $DIR/same_seed/test2.conf | grep -v "^Framework\|^INFO\|^Terminating" > test_output/cached_shard.expected
+touch -d "1 hour ago" test_output/result_cache/0000000000000000.fwc.tmp1.0
+../bin/framework --shard 2/3 test_output/cached_test2.conf > test_output/cached_shard
+grep -v "^Framework\|^INFO\|^Terminating" test_output/cached_shard > test_output/cached_shard.out
+if cmp -s test_output/cached_shard.expected test_output/cached_shard.out \
+        && ! grep -q "^INFO: Took 0 of" test_output/cached_shard \
+        && ! ls test_output/result_cache | grep -q "\.tmp" ; then
+    echo "passed shards with the result cache"
+else
+    echo "failed shards with the result cache" >&2
+
+    rm -rf test_output
+    exit 1;
+fi
+
+# test a simulation whose last module changed only executes that module, and
+# the cache stays within its size limit
+sed "s/^modules = .*/modules = Module1 Module2 Module3 Module4/" test_output/cached_test2.conf > test_output/cached_edited.conf
+grep -v "^result_cache" test_output/cached_edited.conf > test_output/edited.conf
+../bin/framework test_output/edited.conf | grep -v "^Framework\|^INFO\|^Terminating" > test_output/cached_edited.expected
+for run in edited limited; do
+    if [ $run = limited ] ; then
+        echo "result_cache_size = 1" >> test_output/cached_edited.conf
+    fi
+    ../bin/framework test_output/cached_edited.conf > test_output/cached_edited.$run
+    grep -v "^Framework\|^INFO\|^Terminating" test_output/cached_edited.$run > test_output/cached_edited.out
+
+    if cmp -s test_output/cached_edited.expected test_output/cached_edited.out \
+            && ( [ $run = limited ] || grep -q "^INFO: Took 300000 of 400000 module results" test_output/cached_edited.$run ) \
+            && ( [ $run = edited ] || [ $(cat test_output/result_cache/* | wc -c) -le 1048576 ] ) ; then
+        echo "passed ${run} modules with the result cache"
+    else
+        echo "failed ${run} modules with the result cache" >&2
+
+        rm -rf test_output
+        exit 1;
+    fi
+done
+
+# test binary results convert back to the text results
+echo "testing binary results convert back to the text results..."
+for test in $DIR/binary_output/*.conf; do
+    name=$(basename $test)
+    grep -v "^output_" $test > test_output/text_$name
+    ../bin/framework test_output/text_$name | grep -v "^Framework\|^INFO\|^Terminating" > test_output/text_$name.out
+    ../bin/framework $test > /dev/null 2>&1
+    ../bin/framework_convert test_output/binary_$(basename $test .conf).bin > test_output/binary_$name.out
+
+    if cmp -s test_output/text_$name.out test_output/binary_$name.out ; then
+        echo "passed ${test}"
+    else
+        echo "failed ${test}" >&2
+
+        rm -rf test_output
+        exit 1;
+    fi
+done
+
+# test resumed simulations produce the results of an uninterrupted run
+echo "testing simulations resumed from a checkpoint..."
+for test in $DIR/checkpoint/*.conf; do
+    name=$(basename $test)
+    grep -v "^output_\|^checkpoint_" $test > test_output/uninterrupted_$name
+    ../bin/framework test_output/uninterrupted_$name | grep -v "^Framework\|^INFO\|^Terminating" > test_output/uninterrupted_$name.out
+
+    # interrupt the simulation once it took its first checkpoint, until a
+    # run is caught before its last one
+    checkpoint=$(sed -n "s/^checkpoint_file = //p" $test)
+    number_of_events=$(sed -n "s/^number_of_events = //p" $test)
+    for attempt in $(seq 10); do
+        rm -f $checkpoint
+        ../bin/framework $test > /dev/null 2>&1 &
+        run=$!
+        while kill -0 $run 2> /dev/null && [ ! -e $checkpoint ]; do
+            sleep 0.01
+        done
+        kill -KILL $run 2> /dev/null
+        wait $run 2> /dev/null
+        next_event=$(sed -n "s/^next_event = //p" $checkpoint 2> /dev/null)
+        [ -n "$next_event" ] && [ $next_event -le $number_of_events ] && break
+    done
+
+    # the resumed run continues after the events of the checkpoint
+    ../bin/framework --resume $test > test_output/resume_$name.log 2>&1
+    output=$(sed -n "s/^output_file = //p" $test)
+    if grep -q "^output_format = binary" $test ; then
+        ../bin/framework_convert $output > test_output/resumed_$name.out
+    else
+        cp $output test_output/resumed_$name.out
+    fi
+
+    if [ -n "$next_event" ] && [ $next_event -le $number_of_events ] \
+            && grep -q "^INFO: Resuming from event $next_event$" test_output/resume_$name.log \
+            && cmp -s test_output/uninterrupted_$name.out test_output/resumed_$name.out ; then
+        echo "passed ${test}"
+    else
+        echo "failed ${test}" >&2
+
+        rm -rf test_output
+        exit 1;
+    fi
+done
+
+# test a simulation whose results can't be written fails
+echo "testing simulations failing to write their results fail..."
+for output in "" "output_file = /dev/full"; do
+    (cat $DIR/test1.conf; echo; echo "$output") > test_output/full.conf
+    if ../bin/framework test_output/full.conf > /dev/full 2> /dev/null ; then
+        echo "failed writing to /dev/full with ${output:-standard out}" >&2
+
+        rm -rf test_output
+        exit 1;
+    else
+        echo "passed writing to /dev/full with ${output:-standard out}"
+    fi
+done
+
 # test same file produce different results
 echo "testing simulation with random seeds produce different result..."
 for test in $DIR/*.conf; do